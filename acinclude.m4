@@ -28,10 +28,12 @@ m4_include(config/m4/acinclude.nm.m4)
 m4_include(config/m4/acinclude.omp.m4)
 m4_include(config/m4/acinclude.otf.m4)
 m4_include(config/m4/acinclude.papi.m4)
+m4_include(config/m4/acinclude.perf.m4)
 m4_include(config/m4/acinclude.pform.m4)
 m4_include(config/m4/acinclude.plugincntr.m4)
 m4_include(config/m4/acinclude.pthread.m4)
 m4_include(config/m4/acinclude.rusage.m4)
+m4_include(config/m4/acinclude.sample.m4)
 m4_include(config/m4/acinclude.tauinst.m4)
 m4_include(config/m4/acinclude.threads.m4)
 m4_include(config/m4/acinclude.timer.m4)
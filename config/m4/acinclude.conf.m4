@@ -287,6 +287,10 @@ AC_DEFUN([ACVT_CONF_SUMMARY],
 		[answer="yes"], [answer="no"])
 		echo "  Build GLIBC's CPU ID trace support:        $answer"
 
+		AS_IF([test x"$have_sample" = "xyes"],
+		[answer="yes"], [answer="no"])
+		echo "  Build statistical sampling support:        $answer"
+
 		AS_IF([test x"$have_libwrap" = "xyes"],
 		[
 			answer=
@@ -1,7 +1,7 @@
 AC_DEFUN([ACVT_METRICS],
 [
 	metrics_error="no"
-	check_metrics="papi cpc necsx"
+	check_metrics="papi cpc necsx perf"
 	force_metrics="no"
 	have_metrics="no"
 
@@ -9,13 +9,13 @@ AC_DEFUN([ACVT_METRICS],
 
 	AC_ARG_ENABLE(metrics,
 		AC_HELP_STRING([--enable-metrics=TYPE],
-			[enable support for hardware performance counter (papi,cpc,necsx), default: automatically by configure]),
+			[enable support for hardware performance counter (papi,cpc,necsx,perf), default: automatically by configure]),
 	[
 		AS_IF([test x"$enableval" = "xno"], [check_metrics="no"])
 		AS_IF([test x"$enableval" = "xyes"], [force_metrics="yes"])
 		AS_IF([test x"$enableval" != "xyes" -a x"$enableval" != "xno"],
 		[
-			AS_IF([test x"$enableval" != "xpapi" -a x"$enableval" != "xcpc" -a x"$enableval" != "xnecsx"],
+			AS_IF([test x"$enableval" != "xpapi" -a x"$enableval" != "xcpc" -a x"$enableval" != "xnecsx" -a x"$enableval" != "xperf"],
 			[AC_MSG_ERROR([value of '--enable-metrics' not properly set])])
 			check_metrics="$enableval"
 			force_metrics="yes"
@@ -54,6 +54,12 @@ AC_DEFUN([ACVT_METRICS],
 					AC_MSG_RESULT([no])
 				])
 			])
+			AS_IF([test x"$cm" = "xperf"],
+			[
+				ACVT_CONF_SUBTITLE([Linux perf events])
+				ACVT_PERF
+				AS_IF([test x"$have_perf" = "xyes"], [have_metrics="yes"; break])
+			])
 		done
 
 		AS_IF([test x"$have_metrics" = "xno"], [metrics_error="yes"])
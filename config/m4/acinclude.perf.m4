@@ -0,0 +1,49 @@
+AC_DEFUN([ACVT_PERF],
+[
+	perf_error="no"
+	have_perf="no"
+
+	AC_CHECK_HEADER([linux/perf_event.h], [],
+	[
+		AC_MSG_NOTICE([error: no linux/perf_event.h found])
+		perf_error="yes"
+	])
+
+	AS_IF([test x"$perf_error" = "xno"],
+	[
+		AC_MSG_CHECKING([for perf_event_open system call])
+		AC_TRY_COMPILE(
+[
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+],
+[
+struct perf_event_attr attr;
+attr.read_format = PERF_FORMAT_GROUP;
+attr.config = PERF_COUNT_SW_TASK_CLOCK;
+return (int)__NR_perf_event_open;
+],
+		[AC_MSG_RESULT([yes])], [AC_MSG_RESULT([no]); perf_error="yes"])
+	])
+
+	AS_IF([test x"$perf_error" = "xno"],
+	[
+		AC_MSG_CHECKING([whether perf events can be read by rdpmc])
+		AC_TRY_COMPILE(
+[
+#include <linux/perf_event.h>
+],
+[
+#if !defined(__x86_64__) && !defined(__i386__)
+#  error "rdpmc is not available"
+#endif
+struct perf_event_mmap_page pc;
+return (int)(pc.cap_user_rdpmc + pc.pmc_width);
+],
+		[AC_MSG_RESULT([yes])
+		 AC_DEFINE([HAVE_PERF_RDPMC], [1], [Define to 1 if perf events can be read by the rdpmc instruction.])],
+		[AC_MSG_RESULT([no])])
+
+		have_perf="yes"
+	])
+])
@@ -26,6 +26,13 @@ AC_DEFUN([ACVT_PTHREAD],
                                 pthread_condattr_setpshared \
                                 pthread_mutexattr_getpshared \
                                 pthread_mutexattr_setpshared])
+
+		AC_MSG_CHECKING([whether the compiler supports thread-local storage])
+		AC_TRY_LINK([static __thread int tls_var = 0;],
+		[tls_var = 1; return tls_var - 1;],
+		[AC_MSG_RESULT([yes])
+		 AC_DEFINE([HAVE_TLS], [1], [Define to 1 if the compiler supports thread-local storage by the '__thread' keyword.])],
+		[AC_MSG_RESULT([no])])
 		CFLAGS=$sav_CFLAGS
 		LIBS=$sav_LIBS
 
@@ -0,0 +1,59 @@
+AC_DEFUN([ACVT_SAMPLE],
+[
+	sample_error="no"
+	check_sample="yes"
+	force_sample="no"
+	have_sample="no"
+
+	SAMPLELIB=
+
+	AC_ARG_ENABLE(sampling,
+		AC_HELP_STRING([--enable-sampling], [enable statistical sampling support, default: enable if found by configure]),
+	[AS_IF([test x"$enableval" = "xyes"], [force_sample="yes"], [check_sample="no"])])
+
+	AS_IF([test x"$check_sample" = "xyes"],
+	[
+		AS_IF([test x"$compinst_type" != "xgnu" -a x"$compinst_type" != "xpgi9"],
+		[
+			AC_MSG_NOTICE([error: sampling requires the symbol table of the GNU compiler instrumentation])
+			sample_error="yes"
+		])
+
+		AS_IF([test x"$sample_error" = "xno"],
+		[
+			AC_CHECK_HEADERS([signal.h time.h ucontext.h], [],
+			[
+				AC_MSG_NOTICE([error: no signal.h, time.h, or ucontext.h found])
+				sample_error="yes"
+			])
+		])
+
+		AS_IF([test x"$sample_error" = "xno"],
+		[
+			dnl the signal handler walks the frame pointers of the interrupted context
+			case $host_cpu in
+				x86_64 | i?86 | aarch64)
+					;;
+				*)
+					AC_MSG_NOTICE([error: sampling is not supported on $host_cpu])
+					sample_error="yes"
+					;;
+			esac
+		])
+
+		AS_IF([test x"$sample_error" = "xno"],
+		[
+			sav_LIBS=$LIBS
+			AC_SEARCH_LIBS([timer_create], [rt],
+			[AS_IF([test x"$ac_cv_search_timer_create" != "xnone required"],
+			 [SAMPLELIB="$ac_cv_search_timer_create"])],
+			[sample_error="yes"])
+			LIBS=$sav_LIBS
+		])
+
+		AS_IF([test x"$sample_error" = "xno"], [have_sample="yes"])
+	])
+
+	AC_SUBST(SAMPLELIB)
+])
+
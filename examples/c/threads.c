@@ -0,0 +1,85 @@
+/*
+ * Thread test program:
+ * Runs more threads at the same time than the initial size of
+ * VampirTrace's vector of thread objects (64)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#ifdef MANUAL
+#include "vt_user.h"
+#endif
+
+#define NTHREADS 100
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int nwaiting = 0;
+
+static void* work(void* arg)
+{
+  int id = *(int*)arg;
+  long sum = 0;
+  int i;
+
+#ifdef MANUAL
+  VT_USER_START("work");
+#endif
+
+  /* wait until all threads are running, so none of them
+     reuses the thread object of a terminated one */
+  pthread_mutex_lock(&mutex);
+  if (++nwaiting == NTHREADS)
+    pthread_cond_broadcast(&cond);
+  else
+    while (nwaiting < NTHREADS)
+      pthread_cond_wait(&cond, &mutex);
+  pthread_mutex_unlock(&mutex);
+
+  for (i = 0; i <= id * 1000; i++)
+    sum += i;
+
+#ifdef MANUAL
+  VT_USER_END("work");
+#endif
+
+  return (void*)sum;
+}
+
+int main(int argc, char *argv[])
+{
+  pthread_t threads[NTHREADS];
+  int ids[NTHREADS];
+  void* ret;
+  int i;
+
+#ifdef MANUAL
+  VT_USER_START("main");
+#endif
+
+  for (i = 0; i < NTHREADS; i++) {
+    ids[i] = i;
+    if (pthread_create(&threads[i], NULL, work, &ids[i]) != 0) {
+      fprintf(stderr, "Could not create thread %i\n", i);
+      exit(1);
+    }
+  }
+
+  for (i = 0; i < NTHREADS; i++) {
+    pthread_join(threads[i], &ret);
+    if ((long)ret != (long)i * 1000 * ((long)i * 1000 + 1) / 2) {
+      fprintf(stderr, "Thread %i returned a wrong result\n", i);
+      exit(1);
+    }
+  }
+
+  printf("%i threads done\n", NTHREADS);
+
+#ifdef MANUAL
+  VT_USER_END("main");
+#endif
+
+  return 0;
+}
@@ -6,13 +6,26 @@
 
 #include "vt_inttypes.h"
 
+#include "util/htab.h"
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define CSTACK_BSIZE 0x80 /* call stack block size */
-#define HASH_MAX 0x3fd    /* size of hash table */
+#define CSTACK_BSIZE  0x80   /* call stack block size */
+#define RINFV_CHUNK   0x1000 /* number of region infos per chunk of the
+				rid-indexed table */
+#define RINFV_NCHUNKS 0x400  /* max. number of chunks of the rid-indexed
+				table */
+
+/* memory barrier for publishing entries of the rid-indexed table, which
+   is read without locking */
+#if defined(HAVE_SYNC_BUILTINS) && HAVE_SYNC_BUILTINS
+# define RINFV_BARRIER() __sync_synchronize()
+#else /* HAVE_SYNC_BUILTINS */
+# define RINFV_BARRIER()
+#endif /* HAVE_SYNC_BUILTINS */
 
 /* data structure for call stack entry */
 
@@ -41,9 +54,14 @@ struct RFG_Regions_struct
 
   RFG_RegionStack* stack;     /* instance for call stack */
 
-  RFG_RegionInfo*  htab[HASH_MAX];   /* hash table for mapping
-					region id's and infos
-					(call limit, group, region name,...) */
+  VTHtab*          htab;      /* hash table for mapping
+				 region id's and infos
+				 (call limit, group, region name,...) */
+
+  RFG_RegionInfo* volatile* volatile rinfv[RINFV_NCHUNKS];
+				/* region infos indexed by region id;
+				   the chunks are allocated on demand
+				   and never move */
 };
 
 /* initializes call stack */
@@ -51,23 +69,25 @@ static int             stack_init( RFG_RegionStack** stack );
 /* enlarges call stack */
 static int             stack_enlarge( RFG_RegionStack* stack );
 
+/* puts region info to rid-indexed table */
+static void            index_put( RFG_Regions* regions,
+				  RFG_RegionInfo* rinf );
+/* gets region info from rid-indexed table */
+static RFG_RegionInfo* index_get( RFG_Regions* regions, uint32_t rid );
+
 /* puts region info to hash table */
-static void            hash_put( RFG_RegionInfo** htab, uint32_t h,
+static RFG_RegionInfo* hash_put( VTHtab* htab, uint32_t h,
 				 const char* g, const char* r,
 				 int32_t l );
 /* gets the region info by id */
-static RFG_RegionInfo* hash_get( RFG_RegionInfo** htab, uint32_t h );
-/* frees hash node */
-static void            hash_free_node( RFG_RegionInfo* htab );
+static RFG_RegionInfo* hash_get( VTHtab* htab, uint32_t h );
 /* frees whole hash table */
-static void            hash_free( RFG_RegionInfo** htab );
+static void            hash_free( VTHtab* htab );
 
 RFG_Regions* RFG_Regions_init()
 {
   RFG_Regions* ret;
 
-  uint32_t i;
-
   /* allocate memory for RFG regions object */
 
   ret = ( RFG_Regions* )malloc( sizeof( RFG_Regions ) );
@@ -76,8 +96,11 @@ RFG_Regions* RFG_Regions_init()
 
   /* initalize hash table */
 
-  for( i = 0; i < HASH_MAX; i++ )
-    ret->htab[i] = NULL;
+  ret->htab = vt_htab_create( VT_HTAB_KEY_INT, 0, sizeof( RFG_RegionInfo ) );
+
+  /* initialize rid-indexed table */
+
+  memset( (void*)ret->rinfv, 0, sizeof( ret->rinfv ) );
 
   /* initialize call stack */
 
@@ -114,6 +137,7 @@ RFG_Regions* RFG_Regions_init()
 int RFG_Regions_free( RFG_Regions* regions )
 {
   int ret = 1;
+  uint32_t i;
   
   if( !regions ) return 0;
 
@@ -131,6 +155,11 @@ int RFG_Regions_free( RFG_Regions* regions )
 
   hash_free( regions->htab );
 
+  /* free rid-indexed table */
+
+  for( i = 0; i < RINFV_NCHUNKS; i++ )
+    free( (void*)regions->rinfv[i] );
+
   /* free self */
 
   free( regions );
@@ -203,33 +232,25 @@ int RFG_Regions_addGroupAssign( RFG_Regions* regions,
 int RFG_Regions_getFilteredRegions( RFG_Regions* regions,
 				    uint32_t* r_nrinfs, RFG_RegionInfo*** r_rinfs )
 {
-  uint32_t i;
+  RFG_RegionInfo* curr;
+  size_t pos = 0;
 
   if( !regions ) return 0;
 
   *r_nrinfs = 0;
   *r_rinfs = NULL;
 
-  for( i = 0; i < HASH_MAX; i++ )
+  while( ( curr = ( RFG_RegionInfo* )vt_htab_next( regions->htab, &pos ) ) )
   {
-    if( regions->htab[i] )
+    if( curr->callLimitCD == 0 )
     {
-      RFG_RegionInfo* curr = regions->htab[i];
-      while( curr )
-      {
-	if( curr->callLimitCD == 0 )
-	{
-	  if( *r_nrinfs == 0 )
-	    *r_rinfs = ( RFG_RegionInfo** )malloc( sizeof( RFG_RegionInfo* ) );
-	  else
-	    *r_rinfs = ( RFG_RegionInfo** )realloc( *r_rinfs, ( *r_nrinfs + 1 )
-					   * sizeof( RFG_RegionInfo* ) );
-
-	  (*r_rinfs)[(*r_nrinfs)++] = curr;
-	}
-
-	curr = curr->next;
-      }
+      if( *r_nrinfs == 0 )
+	*r_rinfs = ( RFG_RegionInfo** )malloc( sizeof( RFG_RegionInfo* ) );
+      else
+	*r_rinfs = ( RFG_RegionInfo** )realloc( *r_rinfs, ( *r_nrinfs + 1 )
+					       * sizeof( RFG_RegionInfo* ) );
+
+      (*r_rinfs)[(*r_nrinfs)++] = curr;
     }
   }
 
@@ -364,31 +385,70 @@ RFG_RegionInfo* RFG_Regions_add( RFG_Regions* regions,
 
     /* add region information to hash table */
 
-    hash_put( regions->htab,
-	      rid,
-	      gname,
-	      rname,
-	      climit );
+    rinf = hash_put( regions->htab,
+		     rid,
+		     gname,
+		     rname,
+		     climit );
 
-    rinf = hash_get( regions->htab, rid );
+    index_put( regions, rinf );
   }
 
   return rinf;
 }
 
+RFG_RegionInfo* RFG_Regions_addCopy( RFG_Regions* regions,
+				     const RFG_RegionInfo* rinf )
+{
+  RFG_RegionInfo* ret;
+
+  if( !regions || !rinf ) return NULL;
+
+  /* look for already existing hash node of this region */
+
+  ret = RFG_Regions_get( regions, rinf->regionId );
+  if( !ret )
+  {
+    /* add copy of region information to hash table; the call limit count
+       down starts over */
+
+    ret = hash_put( regions->htab,
+		    rinf->regionId,
+		    rinf->groupName,
+		    rinf->regionName,
+		    rinf->callLimit );
+
+    index_put( regions, ret );
+  }
+
+  return ret;
+}
+
 RFG_RegionInfo* RFG_Regions_get( RFG_Regions* regions, const uint32_t rid )
 {
   RFG_RegionInfo* rinf;
 
   if( !regions ) return NULL;
 
-  /* look for region informations in hash table */
+  /* look for region informations in rid-indexed table or, if the id is
+     out of its range, in hash table */
 
-  rinf = hash_get( regions->htab, rid );
+  if( rid < RINFV_NCHUNKS * RINFV_CHUNK )
+    rinf = index_get( regions, rid );
+  else
+    rinf = hash_get( regions->htab, rid );
 
   return rinf;
 }
 
+RFG_RegionInfo* RFG_Regions_getIndexed( RFG_Regions* regions,
+					const uint32_t rid )
+{
+  if( !regions || rid >= RINFV_NCHUNKS * RINFV_CHUNK ) return NULL;
+
+  return index_get( regions, rid );
+}
+
 static int stack_init( RFG_RegionStack** stack )
 {
   /* allocate memory for call stack object */
@@ -432,54 +492,76 @@ static int stack_enlarge( RFG_RegionStack* stack )
   return 1;
 }
 
-static void hash_put( RFG_RegionInfo** htab, uint32_t h,
-		      const char* g, const char* r,
-		      int32_t l )
+static void index_put( RFG_Regions* regions, RFG_RegionInfo* rinf )
 {
-  uint32_t id         = h % HASH_MAX;
-  RFG_RegionInfo* add = ( RFG_RegionInfo* )malloc( sizeof( RFG_RegionInfo ) );
+  uint32_t chunk = rinf->regionId / RINFV_CHUNK;
+  RFG_RegionInfo* volatile* rinfv;
+
+  if( chunk >= RINFV_NCHUNKS ) return;
+
+  /* allocate chunk, if necessary; the chunk and the region info are
+     completely initialized before they are made visible (barriers), as
+     they may be read by other threads without locking */
+
+  rinfv = regions->rinfv[chunk];
+  if( !rinfv )
+  {
+    rinfv = ( RFG_RegionInfo* volatile* )calloc( RINFV_CHUNK,
+						 sizeof( RFG_RegionInfo* ) );
+    if( !rinfv )
+    {
+      fprintf( stderr, "RFG_Regions_add(): Error: Could not allocate memory\n" );
+      exit( EXIT_FAILURE );
+    }
+    RINFV_BARRIER();
+    regions->rinfv[chunk] = rinfv;
+  }
+
+  RINFV_BARRIER();
+  rinfv[rinf->regionId % RINFV_CHUNK] = rinf;
+}
+
+static RFG_RegionInfo* index_get( RFG_Regions* regions, uint32_t rid )
+{
+  /* the chunk and the region info are read through the pointers loaded
+     before (data dependency), which orders these loads after the loads
+     of the pointers, matching the barriers in index_put */
+  RFG_RegionInfo* volatile* rinfv = regions->rinfv[rid / RINFV_CHUNK];
+
+  return rinfv ? rinfv[rid % RINFV_CHUNK] : NULL;
+}
+
+static RFG_RegionInfo* hash_put( VTHtab* htab, uint32_t h,
+				 const char* g, const char* r,
+				 int32_t l )
+{
+  RFG_RegionInfo* add = ( RFG_RegionInfo* )vt_htab_put_int( htab, h, NULL );
   add->regionId       = h;
   add->groupName      = ( g != NULL ) ? strdup( g ) : NULL;
   add->regionName     = strdup( r );
   add->callLimit      = l;
   add->callLimitCD    = l;
-  add->next           = htab[id];
-  htab[id]            = add;
-}
-
-static RFG_RegionInfo* hash_get(RFG_RegionInfo** htab, uint32_t h)
-{
-  uint32_t id = h % HASH_MAX;
-  RFG_RegionInfo* curr = htab[id];
-  while( curr )
-  {
-    if( curr->regionId == h )
-      return curr;
 
-    curr = curr->next;
-  }
-  return NULL;
+  return add;
 }
 
-static void hash_free_node(RFG_RegionInfo* htab)
+static RFG_RegionInfo* hash_get( VTHtab* htab, uint32_t h )
 {
-  if( htab->next )
-    hash_free_node( htab->next );   /* call recursive */
-
-  free( htab->groupName );
-  free( htab->regionName );
-  free( htab );
+  return ( RFG_RegionInfo* )vt_htab_get_int( htab, h );
 }
 
-static void hash_free(RFG_RegionInfo** htab)
+static void hash_free( VTHtab* htab )
 {
-  uint32_t i;
-  
-  /* free hash nodes */
+  RFG_RegionInfo* curr;
+  size_t pos = 0;
+
+  /* free region/group names of the hash nodes */
 
-  for( i = 0; i < HASH_MAX; i++ )
+  while( ( curr = ( RFG_RegionInfo* )vt_htab_next( htab, &pos ) ) )
   {
-    if( htab[i] )
-      hash_free_node( htab[i] );
+    free( curr->groupName );
+    free( curr->regionName );
   }
+
+  vt_htab_free( htab );
 }
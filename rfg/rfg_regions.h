@@ -22,7 +22,6 @@ typedef struct RFG_RegionInfo_struct
   char*    regionName;       /* region name */
   int32_t  callLimit;        /* call limit */
   int32_t  callLimitCD;      /* call limit count down */
-  struct RFG_RegionInfo_struct* next;
 } RFG_RegionInfo;
 
 /* initalizes RFG regions object */
@@ -76,10 +75,22 @@ int RFG_Regions_stackPop( RFG_Regions* regions,
 RFG_RegionInfo* RFG_Regions_add( RFG_Regions* regions,
 				 const char* rname, uint32_t rid );
 
+/* adds region with the informations of a region of another RFG regions
+   object (e.g. of another thread) without evaluating the filter and group
+   definitions again */
+RFG_RegionInfo* RFG_Regions_addCopy( RFG_Regions* regions,
+				     const RFG_RegionInfo* rinf );
+
 /* gets region informations by region id */
 RFG_RegionInfo* RFG_Regions_get( RFG_Regions* regions,
 				 const uint32_t rid );
 
+/* gets region informations by region id from the rid-indexed table only;
+   unlike RFG_Regions_get, this may be called while another thread adds
+   regions, but returns NULL, if the region id is out of the table's range */
+RFG_RegionInfo* RFG_Regions_getIndexed( RFG_Regions* regions,
+					const uint32_t rid );
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
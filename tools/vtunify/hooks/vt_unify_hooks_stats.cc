@@ -12,10 +12,13 @@
 
 #include "vt_unify.h"
 #include "vt_unify_hooks_stats.h"
+#include "vt_unify_tkfac.h"
 
 #include "vt_inttypes.h"
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include <assert.h>
 #include <stdio.h>
@@ -106,6 +109,161 @@ HooksStats::writeRecHook_FunctionSummary( HooksVaArgs_struct & args )
    addFuncStat( proc_id, func_id, count, incl, excl );
 }
 
+// phase hooks
+//
+
+void
+HooksStats::phaseHook_UnifyStatistics_post()
+{
+   // read function duration histograms of all streams, if available
+   //
+   for( uint32_t i = 0; i < g_vecUnifyCtls.size(); i++ )
+   {
+      if( !g_vecUnifyCtls[i]->stream_avail ) continue;
+
+      readFuncHist( getFuncHistFileName( g_vecUnifyCtls[i]->streamid ),
+                    g_vecUnifyCtls[i]->streamid % 65536 );
+   }
+}
+
+void
+HooksStats::phaseHook_CleanUp_post()
+{
+   if( !Params.doclean || m_mapFuncIdHist.size() == 0 ) return;
+
+   // remove function duration histogram files
+   //
+   for( uint32_t i = 0; i < g_vecUnifyCtls.size(); i++ )
+   {
+      std::string file_name =
+         getFuncHistFileName( g_vecUnifyCtls[i]->streamid );
+
+      if( remove( file_name.c_str() ) == 0 )
+         VPrint( 2, " Removed %s\n", file_name.c_str() );
+   }
+}
+
+bool
+HooksStats::readFuncHist( const std::string & inFile,
+                          const uint32_t mprocess )
+{
+   std::ifstream in( inFile.c_str() );
+   if( !in ) return false;
+
+   VPrint( 2, " Reading function histograms from %s\n", inFile.c_str() );
+
+   TokenFactory * p_tkfac_deffunction = theTokenFactory[TKFAC__DEF_FUNCTION];
+
+   std::string line;
+   while( std::getline( in, line ) )
+   {
+      // skip comments and empty lines
+      if( line.length() == 0 || line[0] == '#' ) continue;
+
+      // line: region max bucket:count ...
+      //
+      std::istringstream iss( line );
+      uint32_t func_id;
+      uint64_t max;
+
+      if( !( iss >> func_id >> max ) )
+      {
+         std::cerr << ExeName << ": Error: "
+                   << "Could not parse line '" << line << "' of "
+                   << inFile << std::endl;
+         return false;
+      }
+
+      uint32_t global_func_id =
+         p_tkfac_deffunction->translateLocalToken( mprocess, func_id );
+      if( global_func_id == 0 ) continue;
+
+      // merge histogram into the global one of the function
+      //
+      struct FuncHist_struct & hist = m_mapFuncIdHist[global_func_id];
+
+      if( max > hist.max ) hist.max = max;
+
+      uint32_t bucket;
+      uint64_t count;
+      char sep;
+      while( iss >> bucket >> sep >> count )
+      {
+         if( sep == ':' && bucket < HIST_NUM )
+            hist.buckets[bucket] += count;
+      }
+   }
+
+   return true;
+}
+
+uint64_t
+HooksStats::getFuncHistPercentile( const uint32_t funcId, const double p )
+{
+   std::map<uint32_t, struct FuncHist_struct>::iterator it =
+      m_mapFuncIdHist.find( funcId );
+   if( it == m_mapFuncIdHist.end() ) return 0;
+
+   const struct FuncHist_struct & hist = it->second;
+   const uint32_t sub_num = 1 << HIST_SUB_BITS;
+
+   if( p >= 1.0 ) return hist.max;
+
+   uint64_t total = 0;
+   uint32_t b;
+
+   for( b = 0; b < HIST_NUM; b++ )
+      total += hist.buckets[b];
+   if( total == 0 ) return 0;
+
+   // rank of the percentile
+   //
+   uint64_t rank = (uint64_t)( p * (double)total + 0.5 );
+   if( rank < 1 ) rank = 1;
+   if( rank > total ) rank = total;
+
+   // search bucket which contains the rank
+   //
+   uint64_t sum = 0;
+   for( b = 0; b < HIST_NUM; b++ )
+   {
+      sum += hist.buckets[b];
+      if( sum >= rank ) break;
+   }
+
+   // last bucket is open-ended
+   if( b >= HIST_NUM - 1 ) return hist.max;
+
+   // return middle of the bucket, but not more than the maximum
+   //
+   uint64_t low, width;
+   if( b < sub_num )
+   {
+      low = b;
+      width = 1;
+   }
+   else
+   {
+      uint32_t shift = b / sub_num - 1;
+      low = (uint64_t)( sub_num + b % sub_num ) << shift;
+      width = (uint64_t)1 << shift;
+   }
+
+   uint64_t value = low + width / 2;
+   return ( value < hist.max ) ? value : hist.max;
+}
+
+std::string
+HooksStats::getFuncHistFileName( const uint32_t streamId )
+{
+   char file_name[STRBUFSIZE];
+
+   snprintf( file_name, sizeof( file_name ) - 1, "%s.%x.hist",
+             Params.in_file_prefix.c_str(), streamId );
+
+   return std::string( file_name );
+}
+
 bool
 HooksStats::addFunc( const uint32_t funcId, const std::string& funcName )
 {
@@ -297,9 +455,13 @@ HooksStats::printFuncStat( std::string outFile,
             (sortFlags & STAT_SORT_FLAG_EXCL_CALL) ? '*' : ' ',
             (sortFlags & STAT_SORT_FLAG_INCL_CALL) ? '*' : ' ' );
 
-   fprintf( out, "%cexcl. time %cincl. time      calls      / call      / call %cname\n",
+   // print percentiles of the durations, if histograms available
+   bool print_hist = m_mapFuncIdHist.size() > 0;
+
+   fprintf( out, "%cexcl. time %cincl. time      calls      / call      / call%s %cname\n",
             (sortFlags & STAT_SORT_FLAG_EXCL) ? '*' : ' ',
             (sortFlags & STAT_SORT_FLAG_INCL) ? '*' : ' ',
+            print_hist ? "         p50         p99         max" : "",
             (sortFlags & STAT_SORT_FLAG_FUNCNAME) ? '*' : ' ' );
 
    // reduce output lines, if necessary
@@ -317,11 +479,32 @@ HooksStats::printFuncStat( std::string outFile,
       std::string str_incl_call =
          formatTime( (uint64_t)((double)vecFuncStat[i].incl / vecFuncStat[i].count) );
       std::string str_funcname = vecFuncStat[i].funcname;
+      std::string str_hist = "";
+
+      if( print_hist )
+      {
+         uint32_t func_id = vecFuncStat[i].funcid;
+         char buf[STRBUFSIZE];
+
+         if( m_mapFuncIdHist.find( func_id ) != m_mapFuncIdHist.end() )
+         {
+            snprintf( buf, sizeof( buf ) - 1, " %11s %11s %11s",
+               formatTime( getFuncHistPercentile( func_id, 0.5 ) ).c_str(),
+               formatTime( getFuncHistPercentile( func_id, 0.99 ) ).c_str(),
+               formatTime( getFuncHistPercentile( func_id, 1.0 ) ).c_str() );
+         }
+         else
+         {
+            snprintf( buf, sizeof( buf ) - 1, " %11s %11s %11s",
+                      "-", "-", "-" );
+         }
+         str_hist = buf;
+      }
 
       if( out == stdout ) str_funcname = shortName( vecFuncStat[i].funcname ); 
 
       fprintf( out,
-               "%11s %11s %10.*f %11s %11s  %s\n",
+               "%11s %11s %10.*f %11s %11s%s  %s\n",
                str_excl.c_str(),
                str_incl.c_str(),
                ((double)((uint64_t)vecFuncStat[i].count) ==
@@ -329,6 +512,7 @@ HooksStats::printFuncStat( std::string outFile,
                vecFuncStat[i].count,
                str_excl_call.c_str(),
                str_incl_call.c_str(),
+               str_hist.c_str(),
                str_funcname.c_str() );
    }
 
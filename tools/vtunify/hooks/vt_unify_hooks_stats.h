@@ -45,6 +45,18 @@ public:
 
    };
 
+   //
+   // layout of the function duration histograms
+   // (see VTSUM_HIST_* in vtlib/vt_otf_sum.c)
+   //
+   enum
+   {
+      HIST_SUB_BITS = 3,  // log2 of number of sub-buckets per power of two
+      HIST_MAX_BITS = 48, // log2 of lower bound of last bucket
+      HIST_NUM      = (HIST_MAX_BITS - HIST_SUB_BITS + 1) << HIST_SUB_BITS
+
+   };
+
    // contructor
    HooksStats();
 
@@ -155,6 +167,19 @@ private:
 
    };
 
+   //
+   // function duration histogram structure
+   //
+   struct FuncHist_struct
+   {
+      FuncHist_struct()
+         : max(0), buckets(HIST_NUM, 0) {}
+
+      uint64_t              max;     // maximum duration
+      std::vector<uint64_t> buckets; // number of calls per bucket
+
+   };
+
    // class for compare function identifier
    //
    class FuncStat_funcId_eq :
@@ -179,6 +204,11 @@ private:
    void writeRecHook_DefFunction( HooksVaArgs_struct & args );
    void writeRecHook_FunctionSummary( HooksVaArgs_struct & args );
 
+   // phase hook methods
+   //
+   void phaseHook_UnifyStatistics_post( void );
+   void phaseHook_CleanUp_post( void );
+
    // add function definiton
    // (called by writeRecHook_DefFunction)
    bool addFunc( const uint32_t funcId, const std::string& funcName );
@@ -189,6 +219,17 @@ private:
                      const uint64_t count, const uint64_t incl,
                      const uint64_t excl );
 
+   // read function duration histograms of a stream from file and
+   // merge them into the global histograms
+   // (called by phaseHook_UnifyStatistics_post)
+   bool readFuncHist( const std::string & inFile, const uint32_t mprocess );
+
+   // get percentile of function durations (0, if no histogram available)
+   uint64_t getFuncHistPercentile( const uint32_t funcId, const double p );
+
+   // get histogram file name of a stream
+   std::string getFuncHistFileName( const uint32_t streamId );
+
    // get vector of function statistics
    //
    std::vector<struct FuncStat_struct> getFuncStat();
@@ -222,6 +263,9 @@ private:
    std::map<uint32_t, std::map<uint32_t, struct FuncStat_struct*>*>
       m_mapProcIdFuncStat;
 
+   // map function id -> function duration histogram
+   std::map<uint32_t, struct FuncHist_struct> m_mapFuncIdHist;
+
    // timer resolution
    uint64_t m_lTimerRes;
 
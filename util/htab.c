@@ -0,0 +1,321 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hash.h"
+#include "htab.h"
+
+#define HTAB_INIT_SIZE   64      /* initial number of slots (power of 2) */
+#define HTAB_ARENA_BSIZE 0x10000 /* size of an arena block */
+
+/* align arena allocations to 8 bytes */
+#define HTAB_ALIGN(_n) (((_n) + 7) & ~((size_t)7))
+
+/* header of each value in the arena */
+typedef struct
+{
+  union
+  {
+    uint64_t    i;   /* integer key */
+    const void* p;   /* pointer to the copy of a string/binary key */
+  } key;
+  size_t len;        /* length of a string/binary key (incl. the NUL) */
+} HtabValHdr;
+
+#define HTAB_HDR_SIZE HTAB_ALIGN(sizeof(HtabValHdr))
+#define HTAB_VAL2HDR(_v) ((HtabValHdr*)((char*)(_v) - HTAB_HDR_SIZE))
+
+/* slot of the table */
+typedef struct
+{
+  uint64_t k;    /* integer key or hash code of string/binary key */
+  void*    val;  /* value; NULL, if the slot is empty */
+} HtabSlot;
+
+/* block of the arena */
+typedef struct HtabBlock_struct
+{
+  struct HtabBlock_struct* next;
+} HtabBlock;
+
+struct VTHtab_struct
+{
+  VTHtabKeyT keytype;
+  size_t     keysize;   /* size of binary keys */
+  size_t     valsize;   /* size of values (aligned) */
+
+  HtabSlot*  slots;
+  size_t     size;      /* number of slots (power of 2) */
+  size_t     num;       /* number of entries */
+
+  HtabBlock* blocks;    /* arena blocks */
+  char*      apos;      /* next free byte of the current arena block */
+  char*      aend;      /* end of the current arena block */
+};
+
+static void htab_error(void)
+{
+  fprintf(stderr, "vt_htab: Out of memory\n");
+  exit(EXIT_FAILURE);
+}
+
+static void* htab_alloc(VTHtab* htab, size_t bytes)
+{
+  void* ret;
+
+  bytes = HTAB_ALIGN(bytes);
+
+  if( htab->apos == NULL || (size_t)(htab->aend - htab->apos) < bytes )
+  {
+    size_t bsize = HTAB_ALIGN(sizeof(HtabBlock)) + bytes;
+    HtabBlock* block;
+
+    if( bsize < HTAB_ARENA_BSIZE ) bsize = HTAB_ARENA_BSIZE;
+
+    block = (HtabBlock*)malloc(bsize);
+    if( block == NULL ) htab_error();
+
+    block->next = htab->blocks;
+    htab->blocks = block;
+    htab->apos = (char*)block + HTAB_ALIGN(sizeof(HtabBlock));
+    htab->aend = (char*)block + bsize;
+  }
+
+  ret = htab->apos;
+  htab->apos += bytes;
+
+  return ret;
+}
+
+static uint64_t htab_hash_int(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static size_t htab_keylen(VTHtab* htab, const void* key)
+{
+  return htab->keytype == VT_HTAB_KEY_STR ?
+    strlen((const char*)key) + 1 : htab->keysize;
+}
+
+static uint64_t htab_hash_key(VTHtab* htab, const void* key, size_t len)
+{
+  return (uint64_t)vt_hash((unsigned char*)key, (unsigned int)len, 0);
+}
+
+static void htab_grow(VTHtab* htab)
+{
+  HtabSlot* old = htab->slots;
+  size_t oldsize = htab->size;
+  size_t i;
+
+  htab->size *= 2;
+  htab->slots = (HtabSlot*)calloc(htab->size, sizeof(HtabSlot));
+  if( htab->slots == NULL ) htab_error();
+
+  for( i = 0; i < oldsize; i++ )
+  {
+    if( old[i].val != NULL )
+    {
+      size_t mask = htab->size - 1;
+      size_t j = (size_t)(htab->keytype == VT_HTAB_KEY_INT ?
+                          htab_hash_int(old[i].k) : old[i].k) & mask;
+
+      while( htab->slots[j].val != NULL ) j = (j + 1) & mask;
+      htab->slots[j] = old[i];
+    }
+  }
+
+  free(old);
+}
+
+/* find the slot of a key; returns the empty slot where to insert it,
+   if it's not present */
+static HtabSlot* htab_find_int(VTHtab* htab, uint64_t key)
+{
+  size_t mask = htab->size - 1;
+  size_t i = (size_t)htab_hash_int(key) & mask;
+
+  while( htab->slots[i].val != NULL && htab->slots[i].k != key )
+    i = (i + 1) & mask;
+
+  return &(htab->slots[i]);
+}
+
+static HtabSlot* htab_find(VTHtab* htab, const void* key, size_t len,
+                           uint64_t hash)
+{
+  size_t mask = htab->size - 1;
+  size_t i = (size_t)hash & mask;
+
+  while( htab->slots[i].val != NULL )
+  {
+    HtabValHdr* hdr;
+
+    /* compare the lengths first, so memcmp never reads beyond the end
+       of a shorter stored key */
+    if( htab->slots[i].k == hash &&
+        (hdr = HTAB_VAL2HDR(htab->slots[i].val))->len == len &&
+        memcmp(hdr->key.p, key, len) == 0 )
+      break;
+
+    i = (i + 1) & mask;
+  }
+
+  return &(htab->slots[i]);
+}
+
+/* allocate a zero-filled value */
+static void* htab_new_val(VTHtab* htab)
+{
+  char* mem = (char*)htab_alloc(htab, HTAB_HDR_SIZE + htab->valsize);
+
+  memset(mem, 0, HTAB_HDR_SIZE + htab->valsize);
+  htab->num++;
+
+  return mem + HTAB_HDR_SIZE;
+}
+
+VTHtab* vt_htab_create(VTHtabKeyT keytype, size_t keysize, size_t valsize)
+{
+  VTHtab* htab = (VTHtab*)calloc(1, sizeof(VTHtab));
+  if( htab == NULL ) htab_error();
+
+  htab->keytype = keytype;
+  htab->keysize = keysize;
+  htab->valsize = HTAB_ALIGN(valsize);
+  htab->size = HTAB_INIT_SIZE;
+  htab->slots = (HtabSlot*)calloc(htab->size, sizeof(HtabSlot));
+  if( htab->slots == NULL ) htab_error();
+
+  return htab;
+}
+
+void vt_htab_clear(VTHtab* htab)
+{
+  while( htab->blocks != NULL )
+  {
+    HtabBlock* next = htab->blocks->next;
+    free(htab->blocks);
+    htab->blocks = next;
+  }
+  htab->apos = htab->aend = NULL;
+
+  memset(htab->slots, 0, htab->size * sizeof(HtabSlot));
+  htab->num = 0;
+}
+
+void vt_htab_free(VTHtab* htab)
+{
+  if( htab == NULL ) return;
+
+  vt_htab_clear(htab);
+  free(htab->slots);
+  free(htab);
+}
+
+size_t vt_htab_size(VTHtab* htab)
+{
+  return htab->num;
+}
+
+void* vt_htab_get_int(VTHtab* htab, uint64_t key)
+{
+  return htab_find_int(htab, key)->val;
+}
+
+void* vt_htab_put_int(VTHtab* htab, uint64_t key, int* created)
+{
+  HtabSlot* slot = htab_find_int(htab, key);
+
+  if( created != NULL ) *created = (slot->val == NULL);
+
+  if( slot->val == NULL )
+  {
+    /* keep the load factor below 1/2 */
+    if( (htab->num + 1) * 2 > htab->size )
+    {
+      htab_grow(htab);
+      slot = htab_find_int(htab, key);
+    }
+
+    slot->k = key;
+    slot->val = htab_new_val(htab);
+    HTAB_VAL2HDR(slot->val)->key.i = key;
+  }
+
+  return slot->val;
+}
+
+void* vt_htab_get(VTHtab* htab, const void* key)
+{
+  size_t len = htab_keylen(htab, key);
+
+  return htab_find(htab, key, len, htab_hash_key(htab, key, len))->val;
+}
+
+void* vt_htab_put(VTHtab* htab, const void* key, int* created)
+{
+  size_t len = htab_keylen(htab, key);
+  uint64_t hash = htab_hash_key(htab, key, len);
+  HtabSlot* slot = htab_find(htab, key, len, hash);
+
+  if( created != NULL ) *created = (slot->val == NULL);
+
+  if( slot->val == NULL )
+  {
+    void* keycopy;
+
+    /* keep the load factor below 1/2 */
+    if( (htab->num + 1) * 2 > htab->size )
+    {
+      htab_grow(htab);
+      slot = htab_find(htab, key, len, hash);
+    }
+
+    keycopy = htab_alloc(htab, len);
+    memcpy(keycopy, key, len);
+
+    slot->k = hash;
+    slot->val = htab_new_val(htab);
+    HTAB_VAL2HDR(slot->val)->key.p = keycopy;
+    HTAB_VAL2HDR(slot->val)->len = len;
+  }
+
+  return slot->val;
+}
+
+const void* vt_htab_key(VTHtab* htab, const void* val)
+{
+  HtabValHdr* hdr = HTAB_VAL2HDR(val);
+
+  return htab->keytype == VT_HTAB_KEY_INT ?
+    (const void*)&(hdr->key.i) : hdr->key.p;
+}
+
+void* vt_htab_next(VTHtab* htab, size_t* pos)
+{
+  while( *pos < htab->size )
+  {
+    void* val = htab->slots[(*pos)++].val;
+    if( val != NULL ) return val;
+  }
+
+  return NULL;
+}
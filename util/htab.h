@@ -0,0 +1,83 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#ifndef _HTAB_H
+#define _HTAB_H
+
+#ifdef __cplusplus
+# define EXTERN extern "C"
+#else
+# define EXTERN extern
+#endif
+
+#include <stdlib.h>
+
+#include "vt_inttypes.h"
+
+/*
+ * Growable hash table with open addressing (linear probing)
+ *
+ * The table maps keys to values of a fixed size, which are allocated
+ * (zero-filled) by the table itself from an arena of large memory blocks.
+ * The pointers to the values stay valid until the table is cleared or
+ * freed, also if the table grows. Copies of string and binary keys are
+ * stored in the arena as well.
+ * Entries can't be removed individually. The table is not thread-safe.
+ */
+
+/* key types */
+typedef enum {
+  VT_HTAB_KEY_INT, /* uint64_t keys */
+  VT_HTAB_KEY_STR, /* NUL-terminated string keys */
+  VT_HTAB_KEY_BIN  /* binary keys of a fixed size (e.g. structs) */
+} VTHtabKeyT;
+
+typedef struct VTHtab_struct VTHtab;
+
+/* create a table for values of size `valsize'; `keysize' is the size of
+   binary keys (ignored for integer and string keys) */
+EXTERN VTHtab* vt_htab_create( VTHtabKeyT keytype, size_t keysize,
+                               size_t valsize );
+
+/* remove all entries and release the arena, but keep the table's size */
+EXTERN void vt_htab_clear( VTHtab* htab );
+
+/* free the table including all values */
+EXTERN void vt_htab_free( VTHtab* htab );
+
+/* number of entries */
+EXTERN size_t vt_htab_size( VTHtab* htab );
+
+/* look up the value of an integer key; NULL if not present */
+EXTERN void* vt_htab_get_int( VTHtab* htab, uint64_t key );
+
+/* look up the value of an integer key, insert a zero-filled value if
+   not present; `*created' (if not NULL) tells whether it was inserted */
+EXTERN void* vt_htab_put_int( VTHtab* htab, uint64_t key, int* created );
+
+/* look up the value of a string or binary key; NULL if not present */
+EXTERN void* vt_htab_get( VTHtab* htab, const void* key );
+
+/* look up the value of a string or binary key, insert a zero-filled
+   value if not present; `*created' (if not NULL) tells whether it was
+   inserted */
+EXTERN void* vt_htab_put( VTHtab* htab, const void* key, int* created );
+
+/* get the stored copy of the key of a value returned by vt_htab_put or
+   vt_htab_get (string and binary keys only) */
+EXTERN const void* vt_htab_key( VTHtab* htab, const void* val );
+
+/* iterate over all values (in no particular order); `*pos' has to be
+   0 at the first call; returns NULL after the last value */
+EXTERN void* vt_htab_next( VTHtab* htab, size_t* pos );
+
+#endif /* _HTAB_H */
@@ -0,0 +1,137 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+/*
+ * Benchmark of integer key lookups:
+ * Compares the growable hash table (htab) with the fixed-size chained
+ * hash table of 1021 buckets, which the lookup tables of VampirTrace used
+ * before (e.g. the symbol table of the GNU compiler adapter).
+ * The keys look like function addresses; they are looked up in random
+ * order.
+ *
+ * usage: htab_bench [<number of entries> ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "htab.h"
+
+#define HASH_MAX 1021
+
+/* number of lookups per measurement */
+#define NLOOKUPS 2000000
+
+typedef struct HN {
+  long id;
+  uint32_t vtid;
+  struct HN* next;
+} HashNode;
+
+static HashNode* chain_htab[HASH_MAX];
+
+static void chain_put(long h, uint32_t vtid) {
+  long id = h % HASH_MAX;
+  HashNode* add = (HashNode*)malloc(sizeof(HashNode));
+  if ( add == NULL ) exit(EXIT_FAILURE);
+  add->id = h;
+  add->vtid = vtid;
+  add->next = chain_htab[id];
+  chain_htab[id] = add;
+}
+
+static HashNode* chain_get(long h) {
+  long id = h % HASH_MAX;
+  HashNode* curr = chain_htab[id];
+  while ( curr ) {
+    if ( curr->id == h ) {
+      return curr;
+    }
+    curr = curr->next;
+  }
+  return NULL;
+}
+
+static void chain_free(void) {
+  int i;
+  for ( i = 0; i < HASH_MAX; i++ ) {
+    while ( chain_htab[i] ) {
+      HashNode* next = chain_htab[i]->next;
+      free(chain_htab[i]);
+      chain_htab[i] = next;
+    }
+  }
+}
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void bench(long n) {
+  long* keys = (long*)malloc(n * sizeof(long));
+  long* order = (long*)malloc(NLOOKUPS * sizeof(long));
+  VTHtab* htab = vt_htab_create(VT_HTAB_KEY_INT, 0, sizeof(uint32_t));
+  uint32_t sum = 0;
+  double t0, t_htab, t_chain;
+  long i;
+
+  if ( keys == NULL || order == NULL ) exit(EXIT_FAILURE);
+
+  /* function-address-like keys */
+  for ( i = 0; i < n; i++ ) {
+    keys[i] = 0x400000 + i * 48 + (rand() % 3) * 16;
+    chain_put(keys[i], (uint32_t)i);
+    *(uint32_t*)vt_htab_put_int(htab, (uint64_t)keys[i], NULL) = (uint32_t)i;
+  }
+  for ( i = 0; i < NLOOKUPS; i++ )
+    order[i] = keys[rand() % n];
+
+  t0 = now();
+  for ( i = 0; i < NLOOKUPS; i++ )
+    sum += *(uint32_t*)vt_htab_get_int(htab, (uint64_t)order[i]);
+  t_htab = now() - t0;
+
+  t0 = now();
+  for ( i = 0; i < NLOOKUPS; i++ )
+    sum += chain_get(order[i])->vtid;
+  t_chain = now() - t0;
+
+  printf("%8ld entries: htab %8.1f ns, chained (%d buckets) %8.1f ns "
+         "per lookup (%u)\n", n, t_htab * 1e9 / NLOOKUPS, HASH_MAX,
+         t_chain * 1e9 / NLOOKUPS, sum);
+
+  vt_htab_free(htab);
+  chain_free();
+  free(order);
+  free(keys);
+}
+
+int main(int argc, char** argv) {
+  int i;
+
+  srand(1);
+
+  if ( argc > 1 ) {
+    for ( i = 1; i < argc; i++ )
+      bench(atol(argv[i]));
+  } else {
+    bench(1000);
+    bench(100000);
+    bench(200000);
+  }
+
+  return 0;
+}
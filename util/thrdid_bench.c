@@ -0,0 +1,131 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+/*
+ * Benchmark of the thread-ID lookup of the Pthread-based libraries:
+ * Calls the lookup of VT_MY_THREAD in a tight loop, once as it's done
+ * with thread-local storage (HAVE_TLS) and once by pthread_getspecific,
+ * as it's done without.
+ * The lookup functions are not inlined, like VTThrd_getThreadId, which
+ * lives in another object file.
+ *
+ * usage: thrdid_bench [<number of threads>]
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "vt_inttypes.h"
+
+/* number of lookups per thread */
+#define NLOOKUPS 50000000
+
+static pthread_key_t key;
+
+#if defined(HAVE_TLS)
+static __thread uint32_t tls_id = 0;
+#endif /* HAVE_TLS */
+
+static uint32_t (*volatile lookup)(void);
+
+/* the lookup without thread-local storage (see VTThrd_getThreadId) */
+static uint32_t lookup_key(void)
+{
+  uint32_t* tid = (uint32_t*)pthread_getspecific(key);
+  if ( tid == NULL ) abort();
+  return *tid;
+}
+
+#if defined(HAVE_TLS)
+/* the lookup with thread-local storage (see VT_MY_THREAD) */
+static uint32_t lookup_tls(void)
+{
+  return tls_id != 0 ? tls_id - 1 : lookup_key();
+}
+#endif /* HAVE_TLS */
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void* work(void* arg)
+{
+  uint32_t* tid = (uint32_t*)arg;
+  uint32_t (*f)(void) = lookup;
+  uint32_t sum = 0;
+  long i;
+
+  pthread_setspecific(key, tid);
+#if defined(HAVE_TLS)
+  tls_id = *tid + 1;
+#endif /* HAVE_TLS */
+
+  for ( i = 0; i < NLOOKUPS; i++ )
+    sum += f();
+
+  return (void*)(long)sum;
+}
+
+static void bench(const char* name, uint32_t (*f)(void), int nthreads)
+{
+  pthread_t* threads = (pthread_t*)malloc(nthreads * sizeof(pthread_t));
+  uint32_t* tids = (uint32_t*)malloc(nthreads * sizeof(uint32_t));
+  double t0, t;
+  int i;
+
+  if ( threads == NULL || tids == NULL ) exit(EXIT_FAILURE);
+
+  lookup = f;
+
+  t0 = now();
+  for ( i = 0; i < nthreads; i++ )
+  {
+    tids[i] = (uint32_t)i;
+    if ( pthread_create(&threads[i], NULL, work, &tids[i]) != 0 )
+      exit(EXIT_FAILURE);
+  }
+  for ( i = 0; i < nthreads; i++ )
+    pthread_join(threads[i], NULL);
+  t = now() - t0;
+
+  printf("%-20s %d thread(s): %6.2f ns per lookup\n", name, nthreads,
+         t * 1e9 / ((double)NLOOKUPS * nthreads));
+
+  free(tids);
+  free(threads);
+}
+
+int main(int argc, char** argv)
+{
+  int nthreads = (argc > 1) ? atoi(argv[1]) : 1;
+
+  if ( nthreads < 1 ) nthreads = 1;
+
+  if ( pthread_key_create(&key, NULL) != 0 )
+    return EXIT_FAILURE;
+
+  bench("pthread_getspecific", lookup_key, nthreads);
+#if defined(HAVE_TLS)
+  bench("thread-local", lookup_tls, nthreads);
+#else /* HAVE_TLS */
+  printf("thread-local storage isn't supported by the compiler\n");
+#endif /* HAVE_TLS */
+
+  return 0;
+}
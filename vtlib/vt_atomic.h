@@ -0,0 +1,60 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#ifndef _VT_ATOMIC_H
+#define _VT_ATOMIC_H
+
+#include "config.h"
+
+/*
+ *-----------------------------------------------------------------------------
+ * Atomic operations
+ *-----------------------------------------------------------------------------
+ */
+
+/* VT_HAVE_ATOMICS is defined, if the operations below are safe to use
+   from multiple threads; in the single-threaded libraries they fall back
+   to plain memory operations; VT_ATOMIC_BARRIER is a full memory
+   barrier
+
+   In multi-threaded libraries built without atomic builtins only
+   VT_ATOMIC_BARRIER is defined, as a no-op: all users of the other
+   operations have to check VT_HAVE_ATOMICS and serialize through a mutex
+   otherwise, whose lock and unlock already order the memory accesses */
+
+#if defined(HAVE_SYNC_BUILTINS) && HAVE_SYNC_BUILTINS
+
+# define VT_HAVE_ATOMICS
+
+# define VT_ATOMIC_FETCH_ADD(ptr, val) __sync_fetch_and_add((ptr), (val))
+# define VT_ATOMIC_FETCH_SUB(ptr, val) __sync_fetch_and_sub((ptr), (val))
+# define VT_ATOMIC_CAS(ptr, oldval, newval) \
+  __sync_bool_compare_and_swap((ptr), (oldval), (newval))
+# define VT_ATOMIC_BARRIER() __sync_synchronize()
+
+#elif !(defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
+
+# define VT_HAVE_ATOMICS
+
+# define VT_ATOMIC_FETCH_ADD(ptr, val) ((*(ptr) += (val)) - (val))
+# define VT_ATOMIC_FETCH_SUB(ptr, val) ((*(ptr) -= (val)) + (val))
+# define VT_ATOMIC_CAS(ptr, oldval, newval) \
+  ((*(ptr) == (oldval)) ? (*(ptr) = (newval), 1) : 0)
+# define VT_ATOMIC_BARRIER()
+
+#else /* HAVE_SYNC_BUILTINS */
+
+# define VT_ATOMIC_BARRIER()
+
+#endif /* HAVE_SYNC_BUILTINS */
+
+#endif /* _VT_ATOMIC_H */
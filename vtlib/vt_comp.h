@@ -19,8 +19,19 @@
 #   define EXTERN extern
 #endif
 
+#include "vt_inttypes.h"
+
 /* Compiler adapter finalizer */
 EXTERN void (*vt_comp_finalize)(void);
 
+#if defined(VT_SAMPLE)
+
+/* Get region identifier of the function which contains the code address
+   `addr' from the symbol table of the GNU compiler adapter (used by the
+   sampling mode); returns VT_NO_ID, if the address can't be resolved */
+EXTERN uint32_t gnu_addr2rid(void* addr);
+
+#endif /* VT_SAMPLE */
+
 #endif
 
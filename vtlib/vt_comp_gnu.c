@@ -31,6 +31,8 @@
 #include "vt_trc.h"
 #include "vt_thrd.h"
 
+#include "util/htab.h"
+
 #if (defined(HAVE_DL) && HAVE_DL) && (defined(HAVE_DECL_RTLD_DEFAULT) && HAVE_DECL_RTLD_DEFAULT)
 # include <dlfcn.h>
 # define GET_ADDR_OF_UNDEF_FUNC(func) \
@@ -62,29 +64,33 @@ typedef struct HN {
   char* fname;        /*            file name           */
   int lno;            /*            line number         */
   uint32_t vtid;      /* associated region identifier   */
-  struct HN* next;
 } HashNode;
 
-#define HASH_MAX 1021
+static VTHtab* htab = NULL;
+
+#if defined(VT_SAMPLE)
 
-static HashNode* htab[HASH_MAX];
-static uint32_t n_htab_entries = 0;
+/* hash nodes sorted by address, in order to look up the function which
+   contains a code address */
+static HashNode** addrv = NULL;
+static uint32_t n_addrv_entries = 0;
+
+#endif /* VT_SAMPLE */
 
 /*
  * Stores function name `n' under hash code `h'
  */
 
 static void hash_put(long h, const char* n, const char* fn, int lno) {
-  long id = h % HASH_MAX;
-  HashNode* add = (HashNode*)malloc(sizeof(HashNode));
+  HashNode* add;
+  if ( htab == NULL )
+    htab = vt_htab_create(VT_HTAB_KEY_INT, 0, sizeof(HashNode));
+  add = (HashNode*)vt_htab_put_int(htab, (uint64_t)h, NULL);
   add->id = h;
   add->name  = (char*)n;
   add->fname = fn ? strdup(fn) : (char*)fn;
   add->lno   = lno;
   add->vtid = VT_NO_ID;
-  add->next = htab[id];
-  htab[id] = add;
-  n_htab_entries++;
 }
 
 /*
@@ -93,15 +99,8 @@ static void hash_put(long h, const char* n, const char* fn, int lno) {
  */
 
 static HashNode* hash_get(long h) {
-  long id = h % HASH_MAX;
-  HashNode* curr = htab[id];
-  while ( curr ) {
-    if ( curr->id == h ) {
-      return curr;
-    }
-    curr = curr->next;
-  }
-  return NULL;
+  if ( htab == NULL ) return NULL;
+  return (HashNode*)vt_htab_get_int(htab, (uint64_t)h);
 }
 
 /*
@@ -391,6 +390,42 @@ static void register_region(HashNode* hn) {
                            NULL, VT_FUNCTION);
 }
 
+#if defined(VT_SAMPLE)
+
+static int addr_cmp(const void* a, const void* b) {
+  long ida = (*(HashNode**)a)->id;
+  long idb = (*(HashNode**)b)->id;
+  return (ida < idb) ? -1 : ((ida > idb) ? 1 : 0);
+}
+
+/*
+ * Build vector of hash nodes sorted by address
+ */
+
+static void build_addrv(void) {
+  HashNode** v;
+  HashNode* p;
+  uint32_t n = 0;
+  size_t pos = 0;
+
+  v = (HashNode**)malloc(((htab ? vt_htab_size(htab) : 0) + 1) *
+                         sizeof(HashNode*));
+  if ( v == NULL )
+    vt_error();
+
+  if ( htab != NULL ) {
+    while ( (p = (HashNode*)vt_htab_next(htab, &pos)) )
+      v[n++] = p;
+  }
+
+  qsort(v, n, sizeof(HashNode*), addr_cmp);
+
+  n_addrv_entries = n;
+  addrv = v;
+}
+
+#endif /* VT_SAMPLE */
+
 void gnu_finalize(void);
 void __cyg_profile_func_enter(void* func, void* callsite);
 void __cyg_profile_func_exit(void* func, void* callsite);
@@ -401,52 +436,83 @@ void __cyg_profile_func_exit(void* func, void* callsite);
 
 void gnu_finalize()
 {
-  int i, idx_min, idx_max;
-  uint32_t min, max;
-  double avg;
-  min = 0xffffffff;
-  max = 0;
-  idx_min = idx_max = 0;
-  avg = 0.0;
-
-  for( i = 0; i < HASH_MAX; i++ )
-  {
-    uint32_t n_bucket_entries = 0;
+  HashNode* p;
+  size_t pos = 0;
 
-    struct HN* p = htab[i];
-    while( p )
-    {
-      n_bucket_entries++;
+  if ( htab == NULL ) return;
 
-      /* Set assigned region id back to VT_NO_ID instead of freeing the
-         hash-node, because after a fork the hash-node will be re-used for the
-         child process. This implies a small/non-increasing memory leak. */
-      p->vtid = VT_NO_ID;
-      p = p->next;
-    }
-    if( n_bucket_entries < min ) {
-      min = n_bucket_entries;
-      idx_min = i;
-    }
-    if( n_bucket_entries > max ) {
-      max = n_bucket_entries;
-      idx_max = i;
+  /* Set assigned region ids back to VT_NO_ID instead of freeing the
+     hash-nodes, because after a fork the hash-nodes will be re-used for the
+     child process. This implies a small/non-increasing memory leak. */
+  while ( (p = (HashNode*)vt_htab_next(htab, &pos)) )
+    p->vtid = VT_NO_ID;
+
+  vt_cntl_msg( 3, "Hash statistics:\n"
+                  "\tNumber of entries: %u",
+                  (uint32_t)vt_htab_size(htab) );
+}
+
+#if defined(VT_SAMPLE)
+
+/*
+ * Get region identifier of the function which contains address `addr'
+ * (used by the sampling mode)
+ */
+
+uint32_t gnu_addr2rid(void* addr) {
+  HashNode* hn;
+  long a = (long)addr;
+  uint32_t lo, hi;
+
+  /* -- get symbol table and sort it by address, if not yet done -- */
+  if ( addrv == NULL ) {
+#if (defined(VT_MT) || defined(VT_HYB))
+    VTTHRD_LOCK_IDS();
+#endif /* VT_MT || VT_HYB */
+    if ( addrv == NULL ) {
+      if ( gnu_init ) {
+        gnu_init = 0;
+        vt_comp_finalize = gnu_finalize;
+        get_symtab();
+      }
+      build_addrv();
     }
-    vt_cntl_msg(3, "Hash bucket %i had %u entries (%.1f/1000)",
-                i, n_bucket_entries, ((double)n_bucket_entries*1000)/n_htab_entries);
+#if (defined(VT_MT) || defined(VT_HYB))
+    VTTHRD_UNLOCK_IDS();
+#endif /* VT_MT || VT_HYB */
   }
-  avg = (double)n_htab_entries / HASH_MAX;
-  vt_cntl_msg( 3, "Hash statistics:\n"
-                  "\tNumber of entries: %u\n"
-                  "\tMin bucket size:   %u (%.1f/1000) at index %i\n"
-                  "\tMax bucket size:   %u (%.1f/1000) at index %i\n"
-                  "\tAvg bucket size:   %.1f",
-                  n_htab_entries,
-                  min, ((double)min*1000)/n_htab_entries, idx_min,
-                  max, ((double)max*1000)/n_htab_entries, idx_max,
-                  avg );
+
+  /* -- search the function which starts at or before the address; the
+        address must be below the next symbol's one -- */
+  if ( n_addrv_entries < 2 || a < addrv[0]->id ||
+       a >= addrv[n_addrv_entries-1]->id )
+    return VT_NO_ID;
+
+  lo = 0; hi = n_addrv_entries - 1;
+  while ( hi - lo > 1 ) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if ( addrv[mid]->id <= a ) lo = mid;
+    else hi = mid;
+  }
+  hn = addrv[lo];
+
+  if ( hn->vtid == VT_NO_ID ) {
+    /* -- region sampled the first time, register region -- */
+#if (defined(VT_MT) || defined(VT_HYB))
+    VTTHRD_LOCK_IDS();
+    if( hn->vtid == VT_NO_ID )
+      register_region(hn);
+    VTTHRD_UNLOCK_IDS();
+#else /* VT_MT || VT_HYB */
+    register_region(hn);
+#endif /* VT_MT || VT_HYB */
+  }
+
+  return hn->vtid;
 }
 
+#endif /* VT_SAMPLE */
+
 /*
  * This function is called at the entry of each function
  * The call is generated by the GNU/Intel (>=v10) compilers
@@ -27,6 +27,8 @@ function  /* definition */
 #define VT_MIN_BUFSIZE               0x19000   /* 100KB */
 #define VT_DEFAULT_BUFSIZE           0x2000000 /* 32MB */
 #define VT_DEFAULT_COPY_BUFFER_SIZE  0x100000 /* 1MB */
+#define VT_DEFAULT_POOL_CHUNKSIZE    0x100000 /* 1MB */
+#define VT_CACHE_LINE_SIZE           64       /* assumed size of a cache line */
 
 typedef unsigned char* buffer_t;
 
@@ -70,6 +72,7 @@ typedef unsigned char* buffer_t;
 #define VT_SUM_PROP_MSG     1<<1
 #define VT_SUM_PROP_COLLOP  1<<2
 #define VT_SUM_PROP_FILEOP  1<<3
+#define VT_SUM_PROP_CALLPATH 1<<4
 
 /*
  *-----------------------------------------------------------------------------
@@ -458,6 +458,53 @@ size_t vt_env_copy_bsize()
   return buffer_size;
 }
 
+int vt_env_buffer_pool()
+{
+  static int buffer_pool = -1;
+  char* tmp;
+
+  if (buffer_pool == -1)
+    {
+      tmp = getenv("VT_BUFFER_POOL");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  buffer_pool = parse_bool(tmp);
+	}
+      else
+        {
+	  buffer_pool = 0;
+	}
+    }
+  return buffer_pool;
+}
+
+size_t vt_env_buffer_pool_chunk()
+{
+   static size_t chunk_size = 0;
+   char* tmp;
+
+   if (chunk_size == 0)
+     {
+       tmp = getenv("VT_BUFFER_POOL_CHUNK");
+       if (tmp != NULL && strlen(tmp) > 0)
+         {
+	   chunk_size = parse_size(tmp);
+	   if (chunk_size <= 0)
+	     vt_error_msg("VT_BUFFER_POOL_CHUNK not properly set");
+	   else if (chunk_size < VT_MIN_BUFSIZE) {
+	     vt_warning("VT_BUFFER_POOL_CHUNK=%d resized to %d bytes",
+			chunk_size, VT_MIN_BUFSIZE);
+	     chunk_size = VT_MIN_BUFSIZE;
+	   }
+	 }
+       else
+         {
+	   chunk_size = VT_DEFAULT_POOL_CHUNKSIZE;
+	 }
+     }
+  return chunk_size;
+}
+
 int vt_env_pthread_reuse()
 {
   static int pthread_reuse = -1;
@@ -580,6 +627,9 @@ int vt_env_stat_props()
 		else if(dc <= 2 &&
 			(strcmp( tk, "collop" ) == 0))
 		  propflags |= VT_SUM_PROP_COLLOP;
+		else if(dc <= 3 &&
+			(strcmp( tk, "callpath" ) == 0))
+		  propflags |= VT_SUM_PROP_CALLPATH;
 /*		else if(dc <= 3 &&
 			(strcmp( tk, "fileop" ) == 0))
 			propflags |= VT_SUM_PROP_FILEOP; */
@@ -1236,6 +1286,361 @@ int vt_env_compression()
   return compression;
 }
 
+int vt_env_compression_level()
+{
+  static int compression_level = -1;
+  char* tmp;
+
+  if (compression_level == -1)
+    {
+      tmp = getenv("VT_COMPRESSION_LEVEL");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  compression_level = atoi(tmp);
+	  if (compression_level < 1 || compression_level > 9)
+	    vt_error_msg("VT_COMPRESSION_LEVEL not properly set");
+	}
+      else
+        {
+	  compression_level = 0;
+	}
+    }
+  return compression_level;
+}
+
+int vt_env_close_threads()
+{
+  static int close_threads = -1;
+  char* tmp;
+
+  if (close_threads == -1)
+    {
+      tmp = getenv("VT_CLOSE_THREADS");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  close_threads = atoi(tmp);
+	  if (close_threads < 1)
+	    vt_error_msg("VT_CLOSE_THREADS not properly set");
+	}
+      else
+        {
+	  close_threads = 1;
+	}
+    }
+  return close_threads;
+}
+
+int vt_env_async_flush()
+{
+  static int async_flush = -1;
+  char* tmp;
+
+  if (async_flush == -1)
+    {
+      tmp = getenv("VT_ASYNC_FLUSH");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  async_flush = parse_bool(tmp);
+	}
+      else
+        {
+	  async_flush = 0;
+	}
+    }
+  return async_flush;
+}
+
+int vt_env_async_flush_bufs()
+{
+  static int async_flush_bufs = -1;
+  char* tmp;
+
+  if (async_flush_bufs == -1)
+    {
+      tmp = getenv("VT_ASYNC_FLUSH_BUFFERS");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  async_flush_bufs = atoi(tmp);
+	  if (async_flush_bufs < 2)
+	    vt_error_msg("VT_ASYNC_FLUSH_BUFFERS not properly set");
+	}
+      else
+        {
+	  async_flush_bufs = 2;
+	}
+    }
+  return async_flush_bufs;
+}
+
+int vt_env_buffer_packed()
+{
+  static int buffer_packed = -1;
+  char* tmp;
+
+  if (buffer_packed == -1)
+    {
+      tmp = getenv("VT_BUFFER_PACKED");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  buffer_packed = parse_bool(tmp);
+	}
+      else
+        {
+	  buffer_packed = 0;
+	}
+    }
+  return buffer_packed;
+}
+
+int vt_env_flight_recorder()
+{
+  static int flight_recorder = -1;
+  char* tmp;
+
+  if (flight_recorder == -1)
+    {
+      tmp = getenv("VT_FLIGHT_RECORDER");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  flight_recorder = parse_bool(tmp);
+	}
+      else
+        {
+	  flight_recorder = 0;
+	}
+    }
+  return flight_recorder;
+}
+
+int vt_env_flight_recorder_signal()
+{
+  static int flight_recorder_signal = -1;
+  char* tmp;
+
+  if (flight_recorder_signal == -1)
+    {
+      tmp = getenv("VT_FLIGHT_RECORDER_SIGNAL");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  flight_recorder_signal = atoi(tmp);
+	  if (flight_recorder_signal < 0)
+	    vt_error_msg("VT_FLIGHT_RECORDER_SIGNAL not properly set");
+	}
+      else
+        {
+	  flight_recorder_signal = 0;
+	}
+    }
+  return flight_recorder_signal;
+}
+
+int vt_env_raw_spill()
+{
+  static int raw_spill = -1;
+  char* tmp;
+
+  if (raw_spill == -1)
+    {
+      tmp = getenv("VT_RAW_SPILL");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  raw_spill = parse_bool(tmp);
+	}
+      else
+        {
+	  raw_spill = 0;
+	}
+    }
+  return raw_spill;
+}
+
+int vt_env_min_duration()
+{
+  static int min_duration = -1;
+  char* tmp;
+
+  if (min_duration == -1)
+    {
+      tmp = getenv("VT_MIN_DURATION");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  min_duration = atoi(tmp);
+	  if (min_duration < 0)
+	    vt_error_msg("VT_MIN_DURATION not properly set");
+	}
+      else
+        {
+	  min_duration = 0;
+	}
+    }
+  return min_duration;
+}
+
+int vt_env_sample_intv()
+{
+  static int sample_intv = -1;
+  char* tmp;
+
+  if (sample_intv == -1)
+    {
+      tmp = getenv("VT_SAMPLE_INTV");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  sample_intv = atoi(tmp);
+	  if (sample_intv < 0)
+	    vt_error_msg("VT_SAMPLE_INTV not properly set");
+	}
+      else
+        {
+	  sample_intv = 0;
+	}
+    }
+  return sample_intv;
+}
+
+int vt_env_overhead()
+{
+  static int overhead = -1;
+  char* tmp;
+
+  if (overhead == -1)
+    {
+      tmp = getenv("VT_OVERHEAD");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  overhead = parse_bool(tmp);
+	}
+      else
+        {
+	  overhead = 0;
+	}
+    }
+  return overhead;
+}
+
+int vt_env_stat_callpath_depth()
+{
+  static int callpath_depth = -1;
+  char* tmp;
+
+  if (callpath_depth == -1)
+    {
+      tmp = getenv("VT_STAT_CALLPATH_DEPTH");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  callpath_depth = atoi(tmp);
+	  if (callpath_depth < 0)
+	    vt_error_msg("VT_STAT_CALLPATH_DEPTH not properly set");
+	}
+      else
+        {
+	  callpath_depth = 0;
+	}
+    }
+  return callpath_depth;
+}
+
+int vt_env_stat_callpath_nodes()
+{
+  static int callpath_nodes = -1;
+  char* tmp;
+
+  if (callpath_nodes == -1)
+    {
+      tmp = getenv("VT_STAT_CALLPATH_NODES");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  callpath_nodes = atoi(tmp);
+	  if (callpath_nodes < 0)
+	    vt_error_msg("VT_STAT_CALLPATH_NODES not properly set");
+	}
+      else
+        {
+	  callpath_nodes = 100000;
+	}
+    }
+  return callpath_nodes;
+}
+
+int vt_env_stat_func_hist()
+{
+  static int func_hist = -1;
+  char* tmp;
+
+  if (func_hist == -1)
+    {
+      tmp = getenv("VT_STAT_FUNC_HIST");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  func_hist = parse_bool(tmp);
+	}
+      else
+        {
+	  func_hist = 0;
+	}
+    }
+  return func_hist;
+}
+
+int vt_env_metrics_intv()
+{
+  static int metrics_intv = -1;
+  char* tmp;
+
+  if (metrics_intv == -1)
+    {
+      tmp = getenv("VT_METRICS_INTV");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  metrics_intv = atoi(tmp);
+	  if (metrics_intv < 0)
+	    vt_error_msg("VT_METRICS_INTV not properly set");
+	}
+      else
+        {
+	  metrics_intv = 0;
+	}
+    }
+  return metrics_intv;
+}
+
+int vt_env_metrics_events()
+{
+  static int metrics_events = -1;
+  char* tmp;
+
+  if (metrics_events == -1)
+    {
+      tmp = getenv("VT_METRICS_EVENTS");
+      if (tmp != NULL && strlen(tmp) > 0)
+        {
+	  metrics_events = atoi(tmp);
+	  if (metrics_events < 1)
+	    vt_error_msg("VT_METRICS_EVENTS not properly set");
+	}
+      else
+        {
+	  metrics_events = 1;
+	}
+    }
+  return metrics_events;
+}
+
+char* vt_env_metrics_threshold()
+{
+  static int read = 1;
+  static char* metrics_threshold = NULL;
+
+  if (read)
+    {
+      read = 0;
+      metrics_threshold = getenv("VT_METRICS_THRESHOLD");
+      if ( metrics_threshold != NULL && strlen(metrics_threshold) == 0 )
+	metrics_threshold = NULL;
+    }
+  return metrics_threshold;
+}
+
 int vt_env_java_native()
 {
   static int native = -1;
@@ -34,6 +34,8 @@ EXTERN char*  vt_env_fprefix(void);
 EXTERN int    vt_env_funique(void);
 EXTERN size_t vt_env_bsize(void);
 EXTERN size_t vt_env_copy_bsize(void);
+EXTERN int    vt_env_buffer_pool(void);
+EXTERN size_t vt_env_buffer_pool_chunk(void);
 EXTERN int    vt_env_pthread_reuse(void);
 EXTERN int    vt_env_mode(void);
 EXTERN int    vt_env_stat_intv(void);
@@ -67,6 +69,23 @@ EXTERN int    vt_env_max_stack_depth(void);
 EXTERN int    vt_env_max_flushes(void);
 EXTERN int    vt_env_max_threads(void);
 EXTERN int    vt_env_compression(void);
+EXTERN int    vt_env_compression_level(void);
+EXTERN int    vt_env_close_threads(void);
+EXTERN int    vt_env_async_flush(void);
+EXTERN int    vt_env_async_flush_bufs(void);
+EXTERN int    vt_env_buffer_packed(void);
+EXTERN int    vt_env_flight_recorder(void);
+EXTERN int    vt_env_flight_recorder_signal(void);
+EXTERN int    vt_env_raw_spill(void);
+EXTERN int    vt_env_min_duration(void);
+EXTERN int    vt_env_sample_intv(void);
+EXTERN int    vt_env_overhead(void);
+EXTERN int    vt_env_stat_callpath_depth(void);
+EXTERN int    vt_env_stat_callpath_nodes(void);
+EXTERN int    vt_env_stat_func_hist(void);
+EXTERN int    vt_env_metrics_intv(void);
+EXTERN int    vt_env_metrics_events(void);
+EXTERN char*  vt_env_metrics_threshold(void);
 EXTERN int    vt_env_java_native(void);
 EXTERN int    vt_env_java_synthetic(void);
 EXTERN int    vt_env_java_group_classes(void);
@@ -480,6 +480,7 @@ EXTERN int(*libc_fprintf)(FILE *, const char *, ...);
                 matchingid = VTTHRD_IO_NEXT_MATCHINGID(VTTHRD_MY_VTTHRD); \
                 vt_iobegin( VT_CURRENT_THREAD, &enter_time, matchingid ); \
 	} \
+	VT_OVHD_ADD(VTTHRD_MY_VTTHRD, VT_OVHD_IOWRAP, enter_time); \
 }
 
 /** Write I/O end record
@@ -511,6 +512,7 @@ EXTERN int(*libc_fprintf)(FILE *, const char *, ...);
                 vt_ioend( VT_CURRENT_THREAD, &time, fid, matchingid, handle, ioop, (uint64_t)num_bytes ); \
         } \
         vt_exit( VT_CURRENT_THREAD, &time ); \
+	VT_OVHD_END(VTTHRD_MY_VTTHRD, VT_OVHD_IOWRAP, time); \
 	if( enable_memhooks ) VT_MEMHOOKS_ON(); \
 }
 
@@ -528,6 +530,7 @@ EXTERN int(*libc_fprintf)(FILE *, const char *, ...);
                 vt_ioend( VT_CURRENT_THREAD, &time, FID, matchingid, HANDLE, ioop, (uint64_t)num_bytes ); \
         } \
         vt_exit( VT_CURRENT_THREAD, &time ); \
+        VT_OVHD_END(VTTHRD_MY_VTTHRD, VT_OVHD_IOWRAP, time); \
         if( enable_memhooks ) VT_MEMHOOKS_ON(); \
 }
 
@@ -563,6 +566,7 @@ EXTERN int(*libc_fprintf)(FILE *, const char *, ...);
         	vt_ioend( VT_CURRENT_THREAD, &time, fid, matchingid, handle, ioop, 0 ); \
         } \
         vt_exit( VT_CURRENT_THREAD, &time ); \
+        VT_OVHD_END(VTTHRD_MY_VTTHRD, VT_OVHD_IOWRAP, time); \
         if( enable_memhooks ) VT_MEMHOOKS_ON(); \
 }
 
@@ -591,6 +595,7 @@ EXTERN int(*libc_fprintf)(FILE *, const char *, ...);
                 vt_ioend( VT_CURRENT_THREAD, &time, fid, matchingid, handle, ioop, (uint64_t)num_bytes ); \
         } \
         vt_exit( VT_CURRENT_THREAD, &time ); \
+        VT_OVHD_END(VTTHRD_MY_VTTHRD, VT_OVHD_IOWRAP, time); \
         if( enable_memhooks ) VT_MEMHOOKS_ON(); \
 }
 
@@ -610,6 +615,7 @@ EXTERN int(*libc_fprintf)(FILE *, const char *, ...);
                 vt_ioend( VT_CURRENT_THREAD, &time, fid, matchingid, 0, ioop, 0 ); \
         } \
         vt_exit( VT_CURRENT_THREAD, &time ); \
+        VT_OVHD_END(VTTHRD_MY_VTTHRD, VT_OVHD_IOWRAP, time); \
         if( enable_memhooks ) VT_MEMHOOKS_ON(); \
 }
 
@@ -30,8 +30,8 @@ vampir_file_t unknown_fd_vampir_file;
 
 
 /*
- * Thread safety is achieved through the calling function: vt_iofile_open() is
- * holding VTTHRD_LOCK_IDS when it calls this function
+ * No locking needed: an open fd belongs to one caller only, and the handle is
+ * taken from the calling thread's handle counter
  */
 static void store_vampir_file_id(int fd, uint32_t file_id,
     uint32_t file_group_id)
@@ -79,14 +79,8 @@ void vt_iofile_open(const char* fname, int fd)
   /* fprintf( stderr, "opening file: %s\n", fname); */
   vt_assert( (fd < max_open_files) && (fd >= 0) );
   gid=(fd<3) ? file_group_id_stdio : file_group_id_rest;
-#if defined (VT_MT) || defined (VT_HYB) || defined (VT_JAVA)
-  VTTHRD_LOCK_IDS();
-#endif
   fid = vt_def_file(VT_CURRENT_THREAD, fname, gid);
   store_vampir_file_id(fd, fid, gid);
-#if defined (VT_MT) || defined (VT_HYB) || defined (VT_JAVA)
-  VTTHRD_UNLOCK_IDS();
-#endif
 }
 
 /** Mark the fd as closed */
@@ -103,13 +97,7 @@ uint32_t vt_iofile_id(const char* fname)
 {
   uint32_t fid;
 
-#if defined (VT_MT) || defined (VT_HYB) || defined (VT_JAVA)
-  VTTHRD_LOCK_IDS();
-#endif
   fid = vt_def_file(VT_CURRENT_THREAD, fname, file_group_id_rest);
-#if defined (VT_MT) || defined (VT_HYB) || defined (VT_JAVA)
-  VTTHRD_UNLOCK_IDS();
-#endif
   return fid;
 }
 
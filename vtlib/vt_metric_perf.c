@@ -0,0 +1,419 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <linux/perf_event.h>
+
+#include "vt_defs.h"
+#include "vt_env.h"
+#include "vt_error.h"
+#include "vt_inttypes.h"
+#include "vt_metric.h"
+
+/* read hardware counters by the rdpmc instruction, if the kernel allows it
+   for the calling thread */
+#if defined(HAVE_PERF_RDPMC) && HAVE_PERF_RDPMC && \
+    (defined(__x86_64__) || defined(__i386__))
+# define VT_PERF_RDPMC
+#endif
+
+struct metric
+{
+  char*       name;
+  const char* descr;
+  const char* unit;
+  uint32_t    type;    /* perf_event_attr.type */
+  uint64_t    config;  /* perf_event_attr.config */
+};
+
+/* the counters of a thread form a group, whose leader is the first one;
+   the group is scheduled as a whole and read by a single read() */
+struct vt_metv
+{
+  int fd[VT_METRIC_MAXNUM];
+#if defined(VT_PERF_RDPMC)
+  struct perf_event_mmap_page* page[VT_METRIC_MAXNUM];
+  uint8_t rdpmc;       /* flag: read counters by rdpmc? */
+#endif /* VT_PERF_RDPMC */
+};
+
+/* generalized events which can be specified by name; other events can be
+   specified by their raw code as "r<hex>" */
+static const struct
+{
+  const char* name;
+  uint32_t    type;
+  uint64_t    config;
+  const char* unit;
+  const char* descr;
+} perf_eventv[] =
+{
+  { "cycles",              PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,
+    "#",  "CPU cycles" },
+  { "instructions",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+    "#",  "Retired instructions" },
+  { "cache-references",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES,
+    "#",  "Last level cache accesses" },
+  { "cache-misses",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,
+    "#",  "Last level cache misses" },
+  { "branch-instructions", PERF_TYPE_HARDWARE,
+                           PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    "#",  "Retired branch instructions" },
+  { "branch-misses",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,
+    "#",  "Mispredicted branch instructions" },
+  { "bus-cycles",          PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES,
+    "#",  "Bus cycles" },
+  { "cpu-clock",           PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK,
+    "ns", "CPU clock" },
+  { "task-clock",          PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK,
+    "ns", "Time the thread was running" },
+  { "page-faults",         PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS,
+    "#",  "Page faults" },
+  { "minor-faults",        PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN,
+    "#",  "Minor page faults" },
+  { "major-faults",        PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ,
+    "#",  "Major page faults" },
+  { "context-switches",    PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES,
+    "#",  "Context switches" },
+  { "cpu-migrations",      PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS,
+    "#",  "Migrations to another CPU" },
+  { NULL, 0, 0, NULL, NULL }
+};
+
+/*
+ * Global variables
+ */
+static struct metric* metricv[VT_METRIC_MAXNUM];
+static int nmetrics = 0;
+
+static void metricv_add(char* name)
+{
+  struct metric* metric;
+  int i;
+
+  if ( nmetrics >= VT_METRIC_MAXNUM )
+  {
+    vt_error_msg("Number of counters exceeds VampirTrace allowed maximum "
+		 "of %d", VT_METRIC_MAXNUM);
+  }
+
+  metric = (struct metric*)calloc(1, sizeof(struct metric));
+  if ( metric == NULL )
+    vt_error();
+
+  metric->name = strdup(name);
+
+  /* search for a generalized event */
+  for ( i = 0; perf_eventv[i].name != NULL; i++ )
+  {
+    if ( strcmp(perf_eventv[i].name, name) == 0 )
+    {
+      metric->type = perf_eventv[i].type;
+      metric->config = perf_eventv[i].config;
+      metric->unit = perf_eventv[i].unit;
+      metric->descr = perf_eventv[i].descr;
+      break;
+    }
+  }
+
+  /* otherwise, it has to be a raw event code */
+  if ( perf_eventv[i].name == NULL )
+  {
+    char* end;
+
+    if ( name[0] != 'r' || name[1] == '\0' )
+      vt_error_msg("Unknown perf event %s", name);
+
+    metric->type = PERF_TYPE_RAW;
+    metric->config = (uint64_t)strtoul(name + 1, &end, 16);
+    if ( *end != '\0' )
+      vt_error_msg("Unknown perf event %s", name);
+    metric->unit = "#";
+  }
+
+  metricv[nmetrics++] = metric;
+}
+
+static int perf_event_open(struct perf_event_attr* attr, int group_fd)
+{
+  /* count for the calling thread on any CPU */
+  return (int)syscall(__NR_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+#if defined(VT_PERF_RDPMC)
+
+static uint64_t rdpmc(uint32_t counter)
+{
+  uint32_t low, high;
+
+  __asm__ __volatile__("rdpmc" : "=a" (low), "=d" (high) : "c" (counter));
+
+  return (uint64_t)low | ((uint64_t)high << 32);
+}
+
+/* read a counter by rdpmc as described in linux/perf_event.h; returns 0, if
+   the counter is not available in user space at the moment */
+static int read_rdpmc(struct perf_event_mmap_page* pc, uint64_t* value)
+{
+  uint32_t seq, idx;
+  uint64_t count;
+
+  do
+  {
+    seq = pc->lock;
+    __asm__ __volatile__("" ::: "memory");
+
+    idx = pc->index;
+    if ( !pc->cap_user_rdpmc || idx == 0 )
+      return 0;
+
+    /* sign-extend the counter from its width to 64 bits */
+    count = rdpmc(idx - 1) << (64 - pc->pmc_width);
+    count = pc->offset +
+            (uint64_t)((int64_t)count >> (64 - pc->pmc_width));
+
+    __asm__ __volatile__("" ::: "memory");
+  } while ( pc->lock != seq );
+
+  *value = count;
+  return 1;
+}
+
+#endif /* VT_PERF_RDPMC */
+
+int vt_metric_open()
+{
+  char* env;
+  char* env_sep;
+  char* var;
+  char* token;
+
+  /* read environment variable "VT_METRICS" */
+  if ( ( env = vt_env_metrics() ) == NULL )
+    return 0;
+
+  env_sep = vt_env_metrics_sep();
+
+  var = strdup(env);
+  vt_cntl_msg(2, "VT_METRICS=%s", var);
+
+  /* read metrics from specification string */
+  token = strtok(var, env_sep);
+  while ( token && (nmetrics < VT_METRIC_MAXNUM) )
+  {
+    metricv_add( token );
+    token = strtok(NULL, env_sep);
+  }
+
+  free(var);
+
+  return nmetrics;
+}
+
+void vt_metric_close()
+{
+  int i;
+
+  for ( i = 0; i < nmetrics; i++ )
+  {
+    free(metricv[i]->name);
+    free(metricv[i]);
+  }
+}
+
+struct vt_metv* vt_metric_create()
+{
+  struct vt_metv* metv;
+  int i;
+
+  if ( nmetrics == 0 )
+    return NULL;
+
+  metv = (struct vt_metv*)calloc(1, sizeof(struct vt_metv));
+  if ( metv == NULL )
+    vt_error();
+
+  for ( i = 0; i < nmetrics; i++ )
+  {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = metricv[i]->type;
+    attr.config = metricv[i]->config;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    /* the group starts counting, when all its counters are created */
+    attr.disabled = (i == 0);
+
+    /* count hardware events in user space only (which is also permitted
+       to unprivileged users); software events like context switches occur
+       in the kernel on behalf of the thread */
+    if ( attr.type != PERF_TYPE_SOFTWARE )
+    {
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+    }
+
+    metv->fd[i] = perf_event_open(&attr, i == 0 ? -1 : metv->fd[0]);
+    if ( metv->fd[i] == -1 )
+      vt_error_msg("perf_event_open (%s): %s", metricv[i]->name,
+		   strerror(errno));
+  }
+
+#if defined(VT_PERF_RDPMC)
+  /* use rdpmc, if all counters are hardware counters which the kernel
+     lets read in user space */
+  metv->rdpmc = 1;
+  for ( i = 0; i < nmetrics; i++ )
+  {
+    metv->page[i] = NULL;
+
+    if ( metricv[i]->type == PERF_TYPE_SOFTWARE )
+    {
+      metv->rdpmc = 0;
+      continue;
+    }
+
+    metv->page[i] =
+      (struct perf_event_mmap_page*)mmap(NULL, sysconf(_SC_PAGESIZE),
+                                         PROT_READ, MAP_SHARED,
+                                         metv->fd[i], 0);
+    if ( metv->page[i] == MAP_FAILED )
+    {
+      metv->page[i] = NULL;
+      metv->rdpmc = 0;
+    }
+    else if ( !metv->page[i]->cap_user_rdpmc )
+    {
+      metv->rdpmc = 0;
+    }
+  }
+#endif /* VT_PERF_RDPMC */
+
+  /* start counting */
+  if ( ioctl(metv->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == -1 )
+    vt_error_msg("ioctl (PERF_EVENT_IOC_ENABLE): %s", strerror(errno));
+
+  return metv;
+}
+
+void vt_metric_free(struct vt_metv* metv, uint32_t tid)
+{
+  int i;
+
+  (void)tid;
+
+  if ( metv == NULL )
+    return;
+
+  for ( i = nmetrics - 1; i >= 0; i-- )
+  {
+#if defined(VT_PERF_RDPMC)
+    if ( metv->page[i] != NULL )
+      munmap(metv->page[i], sysconf(_SC_PAGESIZE));
+#endif /* VT_PERF_RDPMC */
+    close(metv->fd[i]);
+  }
+
+  free(metv);
+}
+
+void vt_metric_thread_init(long (*id_fn)(void))
+{
+  (void)id_fn;
+}
+
+void vt_metric_thread_fini()
+{
+}
+
+void vt_metric_read(struct vt_metv* metv, uint64_t offsets[],
+                    uint64_t values[])
+{
+  int i = 0;
+
+  if ( metv == NULL )
+    return;
+
+#if defined(VT_PERF_RDPMC)
+  /* read counters in user space; fall back to read(), if any of them
+     isn't available at the moment */
+  if ( metv->rdpmc )
+  {
+    for ( i = 0; i < nmetrics; i++ )
+    {
+      if ( !read_rdpmc(metv->page[i], &(values[i])) )
+        break;
+    }
+    if ( i != nmetrics )
+      i = 0;
+  }
+#endif /* VT_PERF_RDPMC */
+
+  if ( i == 0 )
+  {
+    /* read counter values of the group: number of counters followed by
+       the values in the order of creation */
+    uint64_t buf[1 + VT_METRIC_MAXNUM];
+    ssize_t bytes = (1 + nmetrics) * sizeof(uint64_t);
+
+    if ( read(metv->fd[0], buf, bytes) != bytes )
+      vt_error_msg("read (perf event group): %s", strerror(errno));
+
+    for ( i = 0; i < nmetrics; i++ )
+      values[i] = buf[1 + i];
+  }
+
+  /* add offsets to values, if necessary */
+  if ( offsets != NULL )
+  {
+    for ( i = 0; i < nmetrics; i++ )
+      values[i] += offsets[i];
+  }
+}
+
+int vt_metric_num()
+{
+  return nmetrics;
+}
+
+const char* vt_metric_name(int i)
+{
+  return metricv[i]->name;
+}
+
+const char* vt_metric_descr(int i)
+{
+  return metricv[i]->descr;
+}
+
+const char* vt_metric_unit(int i)
+{
+  return metricv[i]->unit;
+}
+
+uint32_t vt_metric_props(int i)
+{
+  (void)i;
+  return VT_CNTR_ACC;
+}
@@ -227,16 +227,10 @@ void vt_comm_create(MPI_Comm comm)
       vt_group_to_bitvector( group );
 
       /* register mpi communicator definition */
-#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-      VTTHRD_LOCK_IDS();
-#endif /* VT_MT || VT_HYB || VT_JAVA */
       cid = vt_def_mpi_comm(VT_CURRENT_THREAD,
               comm == MPI_COMM_WORLD ? VT_MPI_COMM_WORLD :
               comm == MPI_COMM_SELF ? VT_MPI_COMM_SELF : VT_MPI_COMM_USER,
               world.size_grpv, grpv);
-#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-      VTTHRD_UNLOCK_IDS();
-#endif /* VT_MT || VT_HYB || VT_JAVA */
 
       /* save communicator id for fast access in vt_comm_id */
       if (comm == MPI_COMM_WORLD) world_cid = cid;
@@ -318,14 +312,8 @@ void vt_group_create(MPI_Group group)
       vt_group_to_bitvector( group );
 
       /* register mpi communicator definition */
-#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-      VTTHRD_LOCK_IDS();
-#endif /* VT_MT || VT_HYB || VT_JAVA */
       cid = vt_def_mpi_comm(VT_CURRENT_THREAD, VT_MPI_COMM_USER,
                             world.size_grpv, grpv);
-#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-      VTTHRD_UNLOCK_IDS();
-#endif /* VT_MT || VT_HYB || VT_JAVA */
 
       /* enter comm in comms[] arrray */
       comms[last_comm].comm  = MPI_COMM_NULL;
@@ -390,13 +378,7 @@ void vt_win_create( MPI_Win win, MPI_Comm comm )
     {
       uint32_t wid;
 
-#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-      VTTHRD_LOCK_IDS();
-#endif /* VT_MT || VT_HYB || VT_JAVA */
       wid = vt_get_curid();
-#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-      VTTHRD_UNLOCK_IDS();
-#endif /* VT_MT || VT_HYB || VT_JAVA */
 
       PMPI_Win_get_group(win, &group); 
 
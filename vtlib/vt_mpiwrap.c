@@ -35,8 +35,18 @@
 
 #include "mpi.h"
 
-/* this macro calls PMPI */
-#define CALL_PMPI(_call, _result) _result = P##_call;
+/* this macro calls PMPI; the time spent in PMPI is excluded from the
+   accounted overhead of the MPI wrapper */
+#define CALL_PMPI(_call, _result)                                              \
+  {                                                                            \
+    VTThrd* _thrd = (vt_ovhd_on && vt_is_alive) ? VTTHRD_MY_VTTHRD : NULL;     \
+    if (_thrd != NULL && _thrd->ovhd_mpiwrap_time != 0)                        \
+      _thrd->ovhd_time[VT_OVHD_MPIWRAP] +=                                     \
+        vt_pform_wtime() - _thrd->ovhd_mpiwrap_time;                           \
+    _result = P##_call;                                                        \
+    if (_thrd != NULL && _thrd->ovhd_mpiwrap_time != 0)                        \
+      _thrd->ovhd_mpiwrap_time = vt_pform_wtime();                             \
+  }
 
 /* macros for calling PMPI and do something before and after it
    syntax: CALL_PMPI_#args(call, [arg1, arg2, ...], result, record, time)
@@ -174,8 +184,16 @@ uint8_t vt_mpi_trace_is_on = 1;
 #define IS_MPI_TRACE_ON ( vt_is_alive && vt_mpi_trace_is_on )
 #define MPI_TRACE_OFF() \
   VT_MEMHOOKS_OFF(); \
-  vt_mpi_trace_is_on = 0;
+  vt_mpi_trace_is_on = 0; \
+  if (vt_ovhd_on) VTTHRD_MY_VTTHRD->ovhd_mpiwrap_time = vt_pform_wtime();
 #define MPI_TRACE_ON() \
+  if (vt_ovhd_on) { \
+    VTThrd* _thrd = VTTHRD_MY_VTTHRD; \
+    if (_thrd->ovhd_mpiwrap_time != 0) { \
+      VT_OVHD_END(_thrd, VT_OVHD_MPIWRAP, _thrd->ovhd_mpiwrap_time); \
+      _thrd->ovhd_mpiwrap_time = 0; \
+    } \
+  } \
   VT_MEMHOOKS_ON(); \
   vt_mpi_trace_is_on = vt_mpitrace;
 
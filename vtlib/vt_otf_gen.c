@@ -12,23 +12,36 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "vt_otf_gen.h"
 #include "vt_otf_sum.h"
+#include "vt_atomic.h"
 #include "vt_defs.h"
 #include "vt_env.h"
 #include "vt_error.h"
 #include "vt_iowrap.h"
 #include "vt_inttypes.h"
 #include "vt_pform.h"
+#include "vt_thrd.h"
 #include "vt_trc.h"
 
 #include "otf.h"
 
+/* asynchronous buffer flushes need a writer thread; it's only available
+   for the Pthread-based libraries */
+#if defined(VT_THRD_PTHREAD)
+# include <pthread.h>
+# define VTGEN_ASYNC_FLUSH
+#endif /* VT_THRD_PTHREAD */
+
 /*
  *-----------------------------------------------------------------------------
  * Macro functions
@@ -39,24 +52,93 @@
   if (gen == NULL) vt_error_msg("Abort: Uninitialized trace buffer")
 
 #define VTGEN_ALLOC_DEF(gen, bytes)                                 \
-  if ((uint64_t)((gen)->buf->pos - (gen)->buf->mem) >               \
-      (uint64_t)((gen)->buf->size - (bytes)))                       \
-    VTGen_flush((gen), 0, vt_pform_wtime(), NULL);
-
-#define VTGEN_ALLOC_EVENT(gen, bytes)                               \
-  if ((uint64_t)((gen)->buf->pos - (gen)->buf->mem) >               \
-      (uint64_t)((gen)->buf->size - (bytes))) {                     \
-    VTGen_flush((gen), 0, *time, time);                             \
+  if ((uint64_t)((gen)->defbuf->pos - (gen)->defbuf->mem) +         \
+      (uint64_t)(bytes) > (uint64_t)(gen)->defbuf->size)            \
+    VTGen_grow_defbuf((gen), (bytes))
+
+#define VTGEN_EVENT_FITS(gen, bytes)                                \
+  ((uint64_t)((gen)->buf->pos - (gen)->buf->mem) +                  \
+   (uint64_t)(bytes) <= (uint64_t)(gen)->buf->size)
+
+/* the event buffers are allocated at the first event record (size 0
+   until then), see VTGen_buffer_full */
+#define VTGEN_RESERVE_EVENT(gen, bytes)                             \
+  if (!VTGEN_EVENT_FITS(gen, bytes)) {                              \
+    VTGen_buffer_full((gen), (bytes), *time, time);                 \
     if((gen)->flushcntr == 0) return;                               \
   }
 
+/* the FLUSH records are written into the space kept free at the end of
+   the buffer (see VTGen_alloc_bufs) rather than by VTGEN_RESERVE_EVENT,
+   which would start a flush itself */
+#define VTGEN_RESERVE_FLUSH(gen, bytes)                             \
+  do {                                                              \
+    if ((gen)->buf->mem == NULL) VTGen_alloc_bufs(gen);             \
+    vt_assert((uint64_t)((gen)->buf->pos - (gen)->buf->mem) +       \
+              (uint64_t)(bytes) <= (uint64_t)(gen)->bufsize);       \
+  } while(0)
+
+#define VTGEN_ALLOC_EVENT(gen, bytes)                               \
+  VTGEN_RESERVE_EVENT(gen, (bytes) + VTGEN_PACKED_HDR_LENGTH(gen))  \
+  VTGEN_PACKED_HDR(gen)
+
 #define VTGEN_ALIGN_LENGTH(bytes)                                   \
-  ( (bytes) % SIZEOF_VOIDP ) ?                                      \
-    ( (bytes) / SIZEOF_VOIDP + 1 ) * SIZEOF_VOIDP : (bytes)
+  (( (bytes) % SIZEOF_VOIDP ) ?                                     \
+    ( (bytes) / SIZEOF_VOIDP + 1 ) * SIZEOF_VOIDP : (bytes))
+
+/* Packed buffer format (VT_BUFFER_PACKED):
+   Each record starts with a one-byte tag. ENTER/LEAVE records are stored
+   as tag, zigzag/varint encoded time delta to the previous packed record
+   of the buffer, and varint encoded region and source code location ids.
+   All other records are stored as tag VTGEN_PACKED_TAG_FULL followed by
+   the usual (aligned) record. */
+
+#define VTGEN_PACKED_TAG_FULL  0
+#define VTGEN_PACKED_TAG_ENTER 1
+#define VTGEN_PACKED_TAG_LEAVE 2
+
+/* maximum length of a packed ENTER/LEAVE record
+   (tag + 64-bit varint + 2 * 32-bit varint) */
+#define VTGEN_PACKED_MAX_LENGTH (1 + 10 + 5 + 5)
+
+#define VTGEN_PACKED_ALIGN(buf, p)                                  \
+  ((buf)->mem + VTGEN_ALIGN_LENGTH((size_t)((p) - (buf)->mem)))
+
+#define VTGEN_PACKED_HDR_LENGTH(gen)                                \
+  ((gen)->ispacked ? SIZEOF_VOIDP : 0)
+
+/* minimum distance between read and write position when shifting records
+   in the flight recorder buffer (max. growth of a re-packed record and its
+   alignment) */
+#define VTGEN_RING_SLACK (VTGEN_PACKED_MAX_LENGTH + SIZEOF_VOIDP)
+
+/* initial size of the definition buffer */
+#define VTGEN_DEFBUF_SIZE 0x10000
+
+#define VTGEN_PACKED_HDR(gen)                                       \
+  if ((gen)->ispacked) {                                            \
+    *((gen)->buf->pos) = VTGEN_PACKED_TAG_FULL;                     \
+    (gen)->buf->pos = VTGEN_PACKED_ALIGN((gen)->buf,                \
+                                         (gen)->buf->pos + 1);      \
+  }
 
 #define VTGEN_JUMP(gen, bytes)                                      \
   gen->buf->pos += (bytes)
 
+#define VTGEN_JUMP_DEF(gen, bytes)                                  \
+  gen->defbuf->pos += (bytes)
+
+/* mark position of an ENTER record, in order that it can be retracted
+   if the call is shorter than VT_MIN_DURATION (see VTGen_write_LEAVE) */
+#define VTGEN_MARK_SHORT(gen, _time)                                \
+  (gen)->shortmark.pos   = (gen)->buf->pos;                         \
+  (gen)->shortmark.time  = *(_time);                                \
+  (gen)->shortmark.ptime = (gen)->buf->ptime;                       \
+  (gen)->shortcntr       = 0
+
+#define VTGEN_SUM(gen)                                              \
+  ((gen)->sum != NULL ? (gen)->sum : VTGen_open_sum(gen))
+
 #define VTGEN_IS_TRACE_ON(gen) ((gen)->mode & VT_MODE_TRACE) != 0
 #define VTGEN_IS_SUM_ON(gen) ((gen)->mode & VT_MODE_STAT) != 0
 #define VTGEN_IS_SUM_PROP_ON(gen, prop) \
@@ -88,6 +170,7 @@ typedef enum { BUF_ENTRY_TYPE__DefinitionComment,
                BUF_ENTRY_TYPE__BeginFileOperation,
                BUF_ENTRY_TYPE__EndFileOperation,
                BUF_ENTRY_TYPE__Counter,
+               BUF_ENTRY_TYPE__Counters,
                BUF_ENTRY_TYPE__Comment,
                BUF_ENTRY_TYPE__Marker,
                BUF_ENTRY_TYPE__SendMsg,
@@ -105,19 +188,33 @@ typedef enum { BUF_ENTRY_TYPE__DefinitionComment,
                BUF_ENTRY_TYPE__FileOperationSummary
 } VTBuf_EntryTypes;
 
-typedef struct
+typedef struct VTBuf_struct
 {
   buffer_t  mem;
   buffer_t  pos;
   size_t    size;
+  uint64_t  ptime;              /* time of last packed record */
+  uint8_t   ispacked;           /* flag: packed buffer format? */
+#if defined(VTGEN_ASYNC_FLUSH)
+  VTGen*    gen;                /* generator which owns the buffer */
+  uint8_t   busy;               /* flag: buffer handed over to writer? */
+  struct VTBuf_struct* next;    /* next buffer in the writer's queue */
+#endif /* VTGEN_ASYNC_FLUSH */
 } VTBuf;
 
 typedef struct
 {
   buffer_t  pos;
   uint64_t  time;
+  uint64_t  ptime;              /* time of last packed record at mark */
 } VTRewind;
 
+typedef struct
+{
+  uint32_t  rid;
+  uint32_t  sid;
+} VTRingRegion;
+
 struct VTGen_struct
 {
   OTF_FileManager*    filemanager;
@@ -132,9 +229,46 @@ struct VTGen_struct
   uint8_t             isfirstflush;
   uint8_t             mode;
   uint8_t             sum_props;
+  uint8_t             ispacked;   /* flag: packed buffer format? */
+  uint8_t             isring;     /* flag: flight recorder mode? */
+  uint32_t            ringdumps;  /* number of handled dump requests */
+  VTRingRegion*       ringstack;  /* regions which are open at the cut
+                                     of the flight recorder buffer */
+  uint32_t            ringstacksize;
+  buffer_t            ringkeep;   /* records of the dropped part of the
+                                     flight recorder buffer which are kept
+                                     (open operations, summaries) */
+  size_t              ringkeeplen;
+  size_t              ringkeepsize;
+  uint32_t            ringkeepnum;
+  uint8_t             isspill;    /* flag: spill raw buffers at
+                                     intermediate flushes? */
+  int                 spillfd;    /* file descriptor of spill file */
+  char*               spillname;  /* name of spill file */
+  uint64_t            spillmax;   /* size of largest spilled buffer */
+  uint64_t            minduration; /* min. duration of recorded calls */
+  VTRewind            shortmark;  /* position of the last ENTER record */
+  buffer_t            shortend;   /* end of the last ENTER record and the
+                                     counter records of its call, if
+                                     they're the last records of the
+                                     buffer */
+  uint8_t             shortcntr;  /* flag: counter records at the time of
+                                     the LEAVE record follow the ENTER? */
+  uint64_t            shortcntrtime; /* time of these counter records */
+  size_t              bufsize;    /* size of each event buffer */
+  uint8_t             ispool;     /* flag: buffer taken from the pool? */
+  size_t              poolsize;   /* bytes of buffer taken from the pool */
   VTRewind            rewindmark;
   VTSum*              sum;
-  VTBuf*              buf;
+  VTBuf*              buf;        /* buffer currently filled */
+  VTBuf**             bufv;       /* vector of all buffers */
+  VTBuf*              defbuf;     /* buffer of definition records */
+  uint32_t            bufn;       /* number of buffers */
+#if defined(VTGEN_ASYNC_FLUSH)
+  uint8_t             isasync;    /* flag: flush buffers asynchronously? */
+  uint32_t            bufs_busy;  /* number of buffers handed over to
+                                     the writer thread */
+#endif /* VTGEN_ASYNC_FLUSH */
 };
 
 typedef struct
@@ -353,6 +487,22 @@ typedef struct
   uint64_t cval;
 } VTBuf_Entry_Counter;
 
+/* BUF_ENTRY_TYPE__Counters */
+
+typedef struct
+{
+  VTBuf_EntryTypes type;
+  uint32_t length;
+
+  uint64_t time;
+  uint32_t num;       /* number of counters */
+  uint64_t cvalv[1];  /* counter values, followed by the counter ids
+                         (see VTGEN_COUNTERS_CIDV) */
+} VTBuf_Entry_Counters;
+
+#define VTGEN_COUNTERS_CIDV(entry) \
+  ((uint32_t*)((entry)->cvalv + (entry)->num))
+
 /* BUF_ENTRY_TYPE__Comment */
 
 typedef struct
@@ -531,205 +681,111 @@ typedef struct
   uint64_t wrote;
 } VTBuf_Entry_FileOperationSummary;
 
-VTGen* VTGen_open(const char* tname, const char* tnamesuffix,
-                  uint32_t ptid, uint32_t tid, size_t buffer_size)
+/* Store val as varint (7 bits per byte, least significant first) */
+static buffer_t VTGen_pack_uint(buffer_t p, uint64_t val)
 {
-  VTGen* gen;
-  char* ldir = vt_env_ldir();
-  char* gdir = vt_env_gdir();
-
-  /* check write permissions */
-
-  if (vt_env_ldir_check())
+  while(val >= 0x80)
   {
-    if (access(ldir, W_OK) != 0)
-      vt_error_msg("Cannot access %s: Permission denied", ldir);
-  }
-  if (vt_env_gdir_check())
-  {
-    if (access(gdir, W_OK) != 0)
-      vt_error_msg("Cannot access %s: Permission denied", gdir);
+    *p++ = (unsigned char)(val | 0x80);
+    val >>= 7;
   }
+  *p++ = (unsigned char)val;
 
-  /* allocate VTGen record */
-  gen = (VTGen*)calloc(1, sizeof(VTGen));
-  if (gen == NULL)
-    vt_error();
-
-  /* store thread name */
-  gen->tname = tname;
-
-  /* store thread name suffix */
-  gen->tnamesuffix = tnamesuffix;
-
-  /* store parent thread id */
-  gen->ptid = ptid;
-
-  /* store thread id */
-  gen->tid = tid;
-
-  /* initialize flush counter */
-  gen->flushcntr = vt_env_max_flushes();
-  if( gen->flushcntr == 0 ) gen->flushcntr = (uint32_t)-1;
+  return p;
+}
 
-  /* initialize first flush flag */
-  gen->isfirstflush = 1;
+static buffer_t VTGen_unpack_uint(buffer_t p, uint64_t* val)
+{
+  uint32_t shift = 0;
 
-  /* initialize trace mode flags */
-  gen->mode = (uint8_t)vt_env_mode();
+  *val = 0;
+  while(*p & 0x80)
+  {
+    *val |= (uint64_t)(*p++ & 0x7f) << shift;
+    shift += 7;
+  }
+  *val |= (uint64_t)(*p++) << shift;
 
-  /* initialize statistics properties */
-  gen->sum_props = (uint8_t)vt_env_stat_props();
+  return p;
+}
 
-  /* allocate VTSum record */
-  gen->sum = NULL;
-  if (VTGEN_IS_SUM_ON(gen))
-    gen->sum = VTSum_open(gen, tid);
+static buffer_t VTGen_pack_EnterLeave(buffer_t p, uint64_t* ptime,
+                                      unsigned char tag, uint64_t time,
+                                      uint32_t rid, uint32_t sid)
+{
+  int64_t delta = (int64_t)(time - *ptime);
 
-  /* allocate buffer record */
+  *p++ = tag;
+  /* zigzag encoding; timestamps passed by the user may go backwards */
+  p = VTGen_pack_uint(p, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+  p = VTGen_pack_uint(p, rid);
+  p = VTGen_pack_uint(p, sid);
 
-  gen->buf = (VTBuf*)malloc(sizeof(VTBuf));
-  if (gen->buf == NULL) 
-    vt_error();
+  *ptime = time;
 
-  /* allocate buffer */
+  return p;
+}
 
-  gen->buf->mem = malloc(buffer_size);
-  if (gen->buf->mem == NULL) 
-    vt_error();
+static buffer_t VTGen_unpack_EnterLeave(buffer_t p, uint64_t* ptime,
+                                        VTBuf_Entry_EnterLeave* entry)
+{
+  uint64_t val;
 
-  /* initialize buffer */
+  entry->type =
+    (*p++ == VTGEN_PACKED_TAG_ENTER) ? BUF_ENTRY_TYPE__Enter :
+                                       BUF_ENTRY_TYPE__Leave;
+  entry->length = 0;
 
-  gen->buf->pos  = gen->buf->mem;
-  /* subtraction leaves space for size of FLUSH record */
-  gen->buf->size =
-    buffer_size - (2 * VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)));
+  p = VTGen_unpack_uint(p, &val);
+  *ptime += (uint64_t)((int64_t)(val >> 1) ^ -(int64_t)(val & 1));
+  entry->time = *ptime;
 
-  /* initialize rewind mark */
-  gen->rewindmark.pos = (buffer_t)-1;
+  p = VTGen_unpack_uint(p, &val);
+  entry->rid = (uint32_t)val;
+  p = VTGen_unpack_uint(p, &val);
+  entry->sid = (uint32_t)val;
 
-  /* return */
-  return gen;
+  return p;
 }
 
-void VTGen_flush(VTGen* gen, uint8_t lastFlush,
-                 uint64_t flushBTime, uint64_t* flushETime )
+/* Write the records of the given buffer to the OTF writer stream;
+   the end of the flush will be marked by a LEAVE_FLUSH record behind
+   the last buffer entry, if markEndFlush is set */
+static void VTGen_write_buf(VTGen* gen, VTBuf* buf, uint8_t markEndFlush,
+                            uint64_t* flushETime)
 {
   uint8_t end_flush_marked = 0;
   buffer_t p;
+  buffer_t next;
+  VTBuf_Entry_EnterLeave unpacked;
+  uint64_t ptime = 0;
 
-  /* intermediate flush and max. buffer flushes reached? */
-  if(!lastFlush && gen->flushcntr == 0) return;
-
-  /* reset buffer, if rank is disabled */
-  if(vt_my_trace_is_disabled)
-  {
-    gen->buf->pos = gen->buf->mem;
-    return;
-  }
-
-  /* disable I/O tracing */
-  VT_SUSPEND_IO_TRACING(gen->tid);
-
-  /* mark begin of flush */
-  if(!lastFlush)
-    vt_enter_flush(gen->tid, &flushBTime);
+  next = buf->mem;
 
-  if(gen->isfirstflush)
+  while(next < buf->pos)
   {
-    /* set base name of the temporary files (basename includes local path
-       but neither thread identifier nor suffix) */
-
-    gen->fileprefix = (char*)calloc(VT_PATH_MAX + 1, sizeof(char));
-    if(gen->fileprefix == NULL)
-      vt_error();
-
-    snprintf(gen->fileprefix, VT_PATH_MAX, "%s/%s.%lx.%u",
-             vt_env_ldir(), vt_env_fprefix(),
-             vt_pform_node_id(), getpid());
-
-    /* open file manager for writer stream */
-    gen->filemanager = OTF_FileManager_open(4);
-
-    /* open writer stream */
-    gen->filestream = OTF_WStream_open(gen->fileprefix, gen->tid+1,
-                                       gen->filemanager);
-
-    if( gen->filestream == NULL )
-      vt_error_msg("Cannot open OTF writer stream [namestub %s id %x]",
-                   gen->fileprefix, gen->tid+1); 
-    else
-      vt_cntl_msg(2, "Opened OTF writer stream [namestub %s id %x] for "
-                     "generation [buffer %d bytes]", 
-                     gen->fileprefix, gen->tid+1, gen->buf->size);
-
-    /* set file compression */
-
-    if( vt_env_compression() &&
-        OTF_WStream_setCompression(gen->filestream,
-                                   OTF_FILECOMPRESSION_COMPRESSED) )
-    {
-      gen->filecomp = OTF_FILECOMPRESSION_COMPRESSED;
-    }
-    else
-    {
-      gen->filecomp = OTF_FILECOMPRESSION_UNCOMPRESSED;
-    }
-
-    if( gen->tid == 0 )
-    {
-      char creator[100];
-      uint64_t res = vt_pform_clockres();
-
-      /* write creator record */
-
-      snprintf(creator, sizeof(creator) - 1,
-               "%s", PACKAGE_STRING);
-
-      OTF_WStream_writeOtfVersion( gen->filestream );
-      OTF_WStream_writeDefCreator( gen->filestream, creator );
-
-      /* write timer resolution record */
-
-      OTF_WStream_writeDefTimerResolution( gen->filestream, res );
-    }
-
-    /* write process definition record */
-    {
-      uint32_t ptid = 0;
-      char pname[1024];
-
-      if(gen->tid != 0)
-        ptid = 65536 * gen->ptid + vt_my_trace + 1;
-
-      snprintf(pname, sizeof(pname) - 1, "%s %d%s",
-               gen->tname, vt_my_trace, gen->tnamesuffix);
-
-      OTF_WStream_writeDefProcess(gen->filestream,
-                                  65536 * gen->tid + vt_my_trace + 1,
-                                  pname, ptid);
-    }
-
-    /* write process group definition record (node name) */
-    {
-       uint32_t pid = 65536 * gen->tid + vt_my_trace + 1;
-       char pgname[100];
-
-       snprintf(pgname, sizeof(pgname) - 1, "__NODE__ %s",
-                vt_pform_node_name());
-
-       OTF_WStream_writeDefProcessGroup(gen->filestream,
-                                        0, /* id will be given by vtunify */
-                                        pgname, 1, &pid);
-    }
+     p = next;
 
-    gen->isfirstflush = 0;
-  }
-
-  p = gen->buf->mem;
+     if(buf->ispacked)
+     {
+       if(*p == VTGEN_PACKED_TAG_FULL)
+       {
+         /* skip tag and padding */
+         p = VTGEN_PACKED_ALIGN(buf, p + 1);
+         next = p + ((VTBuf_Entry_Base*)p)->length;
+       }
+       else
+       {
+         /* unpack ENTER/LEAVE record */
+         next = VTGen_unpack_EnterLeave(p, &ptime, &unpacked);
+         p = (buffer_t)&unpacked;
+       }
+     }
+     else
+     {
+       next = p + ((VTBuf_Entry_Base*)p)->length;
+     }
 
-  while(p < gen->buf->pos)
-  {
      switch(((VTBuf_Entry_Base*)p)->type)
      {
        case BUF_ENTRY_TYPE__DefinitionComment:
@@ -1016,6 +1072,23 @@ void VTGen_flush(VTGen* gen, uint8_t lastFlush,
 
          break;
        }
+       case BUF_ENTRY_TYPE__Counters:
+       {
+         VTBuf_Entry_Counters* entry =
+           (VTBuf_Entry_Counters*)p;
+         uint32_t* cidv = VTGEN_COUNTERS_CIDV(entry);
+         uint32_t i;
+
+         for(i = 0; i < entry->num; i++)
+         {
+           OTF_WStream_writeCounter(gen->filestream,
+             entry->time,
+             65536 * gen->tid + vt_my_trace + 1,
+             cidv[i], entry->cvalv[i]);
+         }
+
+         break;
+       }
        case BUF_ENTRY_TYPE__Comment:
        {
          VTBuf_Entry_Comment* entry =
@@ -1124,151 +1197,1402 @@ void VTGen_flush(VTGen* gen, uint8_t lastFlush,
        {
          VTBuf_Entry_RMAPutGet* entry = (VTBuf_Entry_RMAPutGet*)p;
 
-         OTF_WStream_writeRMAPut(gen->filestream,
-                                 entry->time,
-                                 65536 * gen->tid + vt_my_trace + 1,
-                                 entry->opid,
-                                 entry->tpid,
-                                 entry->cid,
-                                 entry->tag,
-                                 entry->len,
-                                 entry->sid);
-         break;
-       }
-       case BUF_ENTRY_TYPE__RMAPutRE:
-       {
-         VTBuf_Entry_RMAPutGet* entry = (VTBuf_Entry_RMAPutGet*)p;
+         OTF_WStream_writeRMAPut(gen->filestream,
+                                 entry->time,
+                                 65536 * gen->tid + vt_my_trace + 1,
+                                 entry->opid,
+                                 entry->tpid,
+                                 entry->cid,
+                                 entry->tag,
+                                 entry->len,
+                                 entry->sid);
+         break;
+       }
+       case BUF_ENTRY_TYPE__RMAPutRE:
+       {
+         VTBuf_Entry_RMAPutGet* entry = (VTBuf_Entry_RMAPutGet*)p;
+
+         OTF_WStream_writeRMAPutRemoteEnd(gen->filestream,
+                                          entry->time,
+                                          65536 * gen->tid + vt_my_trace + 1,
+                                          entry->opid,
+                                          entry->tpid,
+                                          entry->cid,
+                                          entry->tag,
+                                          entry->len,
+                                          entry->sid);
+          break;
+       }
+       case BUF_ENTRY_TYPE__RMAGet:
+       {
+         VTBuf_Entry_RMAPutGet* entry = (VTBuf_Entry_RMAPutGet*)p;
+
+         OTF_WStream_writeRMAGet(gen->filestream,
+                                 entry->time,
+                                 65536 * gen->tid + vt_my_trace + 1,
+                                 entry->opid,
+                                 entry->tpid,
+                                 entry->cid,
+                                 entry->tag,
+                                 entry->len,
+                                 entry->sid);
+         break;
+       }
+       case BUF_ENTRY_TYPE__RMAEnd:
+       {
+         VTBuf_Entry_RMAEnd* entry = (VTBuf_Entry_RMAEnd*)p;
+
+         OTF_WStream_writeRMAEnd(gen->filestream,
+                                 entry->time,
+                                 65536 * gen->tid + vt_my_trace + 1,
+                                 entry->rpid,
+                                 entry->cid,
+                                 entry->tag,
+                                 entry->sid);
+         break;
+       }
+       case BUF_ENTRY_TYPE__FunctionSummary:
+       {
+         VTBuf_Entry_FunctionSummary* entry =
+           (VTBuf_Entry_FunctionSummary*)p;
+
+         OTF_WStream_writeFunctionSummary(gen->filestream,
+           entry->time,
+           entry->rid,
+           65536 * gen->tid + vt_my_trace + 1,
+           entry->cnt,
+           entry->excl,
+           entry->incl);
+
+         break;
+       }
+       case BUF_ENTRY_TYPE__MessageSummary:
+       {
+         VTBuf_Entry_MessageSummary* entry =
+           (VTBuf_Entry_MessageSummary*)p;
+
+         OTF_WStream_writeMessageSummary(gen->filestream,
+           entry->time,
+           65536 * gen->tid + vt_my_trace + 1,
+           entry->peer,
+           entry->cid,
+           entry->tag,
+           entry->scnt,
+           entry->rcnt,
+           entry->sent,
+           entry->recvd);
+
+         break;
+       }
+       case BUF_ENTRY_TYPE__CollectiveOperationSummary:
+       {
+         VTBuf_Entry_CollectiveOperationSummary* entry =
+           (VTBuf_Entry_CollectiveOperationSummary*)p;
+
+         OTF_WStream_writeCollopSummary(gen->filestream,
+                                        entry->time,
+                                        65536 * gen->tid + vt_my_trace + 1,
+                                        entry->cid,
+                                        entry->rid,
+                                        entry->scnt,
+                                        entry->rcnt,
+                                        entry->sent,
+                                        entry->recvd);
+         break;
+       }
+       case BUF_ENTRY_TYPE__FileOperationSummary:
+       {
+         VTBuf_Entry_FileOperationSummary* entry =
+           (VTBuf_Entry_FileOperationSummary*)p;
+
+         OTF_WStream_writeFileOperationSummary(gen->filestream,
+           entry->time,
+           entry->fid,
+           65536 * gen->tid + vt_my_trace + 1,
+           entry->nopen,
+           entry->nclose,
+           entry->nread,
+           entry->nwrite,
+           entry->nseek,
+           entry->read,
+           entry->wrote);
+
+         break;
+       }
+       default:
+       {
+         vt_assert(0);
+       }
+     }
+
+     /* last buffer entry and end flush not marked ? */
+     if(!end_flush_marked && next >= buf->pos)
+     {
+       /* mark end of flush, if desired */
+       if(markEndFlush)
+       {
+         uint64_t flush_etime = vt_pform_wtime();
+         vt_exit_flush(gen->tid, &flush_etime);
+         if( flushETime != NULL ) *flushETime = flush_etime;
+       }
+
+       end_flush_marked = 1;
+     }
+  }
+}
+
+#if defined(VTGEN_ASYNC_FLUSH)
+
+/* Asynchronous buffer flushes (VT_ASYNC_FLUSH):
+   Filled buffers are queued for a per-process writer thread which converts
+   them to OTF, while the application thread continues recording into a
+   spare buffer. The application thread blocks only if all of its buffers
+   are in flight. */
+
+static pthread_mutex_t async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t async_ctl_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  async_queued_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  async_written_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t async_writer;           /* writer thread */
+static uint32_t  async_gen_num = 0;      /* number of attached generators */
+static uint8_t   async_quit = 0;         /* flag: terminate writer thread? */
+static VTBuf*    async_queue_first = NULL;
+static VTBuf*    async_queue_last = NULL;
+
+static void* VTGen_async_writer(void* arg)
+{
+  VTBuf* buf;
+
+  (void)arg;
+
+  pthread_mutex_lock(&async_mutex);
+
+  for(;;)
+  {
+    /* wait for a queued buffer */
+    while(async_queue_first == NULL && !async_quit)
+      pthread_cond_wait(&async_queued_cond, &async_mutex);
+
+    /* terminate, if requested and the queue is empty */
+    if(async_queue_first == NULL)
+      break;
+
+    /* dequeue buffer */
+    buf = async_queue_first;
+    async_queue_first = buf->next;
+    if(async_queue_first == NULL)
+      async_queue_last = NULL;
+
+    pthread_mutex_unlock(&async_mutex);
+
+    /* write buffer entries; the owner marks the end of the flush */
+    VTGen_write_buf(buf->gen, buf, 0, NULL);
+
+    pthread_mutex_lock(&async_mutex);
+
+    /* give buffer back to its owner */
+    buf->pos = buf->mem;
+    buf->ptime = 0;
+    buf->busy = 0;
+    buf->gen->bufs_busy--;
+    pthread_cond_broadcast(&async_written_cond);
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return NULL;
+}
+
+/* fork handlers: the queue must not change while the process forks */
+static void VTGen_async_atfork_prepare(void)
+{
+  pthread_mutex_lock(&async_mutex);
+}
+
+static void VTGen_async_atfork_parent(void)
+{
+  pthread_mutex_unlock(&async_mutex);
+}
+
+/* The writer thread isn't duplicated into the child process, so nothing
+   would ever give back the buffers in flight or answer a join. The child
+   drops the queued buffers (the parent's writer converts them), forgets
+   the writer thread, and continues with synchronous flushes. */
+static void VTGen_async_atfork_child(void)
+{
+  static const pthread_mutex_t mutex_init = PTHREAD_MUTEX_INITIALIZER;
+  static const pthread_cond_t cond_init = PTHREAD_COND_INITIALIZER;
+  uint32_t tid, i;
+
+  async_mutex = mutex_init;
+  async_ctl_mutex = mutex_init;
+  async_queued_cond = cond_init;
+  async_written_cond = cond_init;
+
+  async_gen_num = 0;
+  async_quit = 0;
+  async_queue_first = async_queue_last = NULL;
+
+  for(tid = 0; tid < VTThrdn; tid++)
+  {
+    VTGen* gen;
+
+    if(VTThrdv[tid] == NULL || (gen = VTThrdv[tid]->gen) == NULL ||
+       !gen->isasync)
+      continue;
+
+    for(i = 0; i < gen->bufn; i++)
+    {
+      if(gen->bufv[i]->busy)
+      {
+        gen->bufv[i]->pos = gen->bufv[i]->mem;
+        gen->bufv[i]->ptime = 0;
+        gen->bufv[i]->busy = 0;
+      }
+    }
+    gen->bufs_busy = 0;
+    gen->isasync = 0;
+  }
+}
+
+static void VTGen_async_attach(void)
+{
+  static uint8_t atfork_registered = 0;
+
+  pthread_mutex_lock(&async_ctl_mutex);
+  pthread_mutex_lock(&async_mutex);
+
+  /* start writer thread, if it's the first generator */
+  if(async_gen_num++ == 0)
+  {
+    if(!atfork_registered)
+    {
+      if(pthread_atfork(VTGen_async_atfork_prepare,
+                        VTGen_async_atfork_parent,
+                        VTGen_async_atfork_child) != 0)
+        vt_error_msg("Cannot register fork handlers for asynchronous "
+                     "flushes");
+      atfork_registered = 1;
+    }
+
+    async_quit = 0;
+    if(pthread_create(&async_writer, NULL, VTGen_async_writer, NULL) != 0)
+      vt_error_msg("Cannot create writer thread for asynchronous flushes");
+
+    vt_cntl_msg(2, "Started writer thread for asynchronous flushes");
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+  pthread_mutex_unlock(&async_ctl_mutex);
+}
+
+static void VTGen_async_detach(void)
+{
+  uint8_t do_join = 0;
+
+  pthread_mutex_lock(&async_ctl_mutex);
+  pthread_mutex_lock(&async_mutex);
+
+  /* terminate writer thread, if it's the last generator */
+  if(--async_gen_num == 0)
+  {
+    async_quit = 1;
+    pthread_cond_signal(&async_queued_cond);
+    do_join = 1;
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  if(do_join)
+  {
+    pthread_join(async_writer, NULL);
+    vt_cntl_msg(2, "Terminated writer thread for asynchronous flushes");
+  }
+
+  pthread_mutex_unlock(&async_ctl_mutex);
+}
+
+static void VTGen_async_handoff(VTGen* gen)
+{
+  VTBuf* buf = gen->buf;
+  uint32_t i;
+
+  pthread_mutex_lock(&async_mutex);
+
+  /* enqueue filled buffer */
+  buf->busy = 1;
+  buf->next = NULL;
+  if(async_queue_last != NULL)
+    async_queue_last->next = buf;
+  else
+    async_queue_first = buf;
+  async_queue_last = buf;
+  gen->bufs_busy++;
+
+  pthread_cond_signal(&async_queued_cond);
+
+  /* wait for a spare buffer, if all buffers are in flight */
+  while(gen->bufs_busy == gen->bufn)
+    pthread_cond_wait(&async_written_cond, &async_mutex);
+
+  /* continue with the first spare buffer */
+  for(i = 0; i < gen->bufn; i++)
+  {
+    if(!gen->bufv[i]->busy)
+    {
+      gen->buf = gen->bufv[i];
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  vt_assert(gen->buf != buf);
+}
+
+static void VTGen_async_drain(VTGen* gen)
+{
+  pthread_mutex_lock(&async_mutex);
+
+  while(gen->bufs_busy > 0)
+    pthread_cond_wait(&async_written_cond, &async_mutex);
+
+  pthread_mutex_unlock(&async_mutex);
+}
+
+#endif /* VTGEN_ASYNC_FLUSH */
+
+/* Raw spill files (VT_RAW_SPILL):
+   Intermediate flushes append the raw buffer contents to a spill file in
+   the local trace directory. The records will be converted to OTF only
+   once, at the last flush. */
+
+static void VTGen_spill_write(VTGen* gen, const void* data, size_t size)
+{
+  const char* p = (const char*)data;
+  ssize_t n;
+
+  while(size > 0)
+  {
+    n = write(gen->spillfd, p, size);
+    if(n == -1)
+    {
+      if(errno == EINTR) continue;
+      vt_error_msg("Cannot write to spill file %s: %s", gen->spillname,
+                   strerror(errno));
+    }
+    p += n;
+    size -= (size_t)n;
+  }
+}
+
+static uint8_t VTGen_spill_read(VTGen* gen, void* data, size_t size)
+{
+  char* p = (char*)data;
+  ssize_t n;
+
+  while(size > 0)
+  {
+    n = read(gen->spillfd, p, size);
+    if(n == -1)
+    {
+      if(errno == EINTR) continue;
+      vt_error_msg("Cannot read from spill file %s: %s", gen->spillname,
+                   strerror(errno));
+    }
+    if(n == 0)
+    {
+      /* end of file */
+      if(p != (char*)data)
+        vt_error_msg("Unexpected end of spill file %s", gen->spillname);
+      return 0;
+    }
+    p += n;
+    size -= (size_t)n;
+  }
+
+  return 1;
+}
+
+static void VTGen_spill_buf(VTGen* gen, VTBuf* buf)
+{
+  uint64_t length = (uint64_t)(buf->pos - buf->mem);
+
+  /* open spill file, if necessary */
+  if(gen->spillfd == -1)
+  {
+    gen->spillname = (char*)calloc(VT_PATH_MAX + 1, sizeof(char));
+    if(gen->spillname == NULL)
+      vt_error();
+
+    snprintf(gen->spillname, VT_PATH_MAX, "%s.%x.spill",
+             gen->fileprefix, gen->tid+1);
+
+    gen->spillfd = open(gen->spillname, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(gen->spillfd == -1)
+      vt_error_msg("Cannot open spill file %s: %s", gen->spillname,
+                   strerror(errno));
+
+    vt_cntl_msg(2, "Opened spill file %s", gen->spillname);
+  }
+
+  /* append buffer length and raw buffer entries */
+  VTGen_spill_write(gen, &length, sizeof(length));
+  VTGen_spill_write(gen, buf->mem, (size_t)length);
+
+  if(length > gen->spillmax)
+    gen->spillmax = length;
+}
+
+static void VTGen_unspill(VTGen* gen)
+{
+  VTBuf buf;
+  uint64_t length;
+
+  if(gen->spillfd == -1) return;
+
+  memset(&buf, 0, sizeof(VTBuf));
+  buf.mem = malloc((size_t)gen->spillmax);
+  if(buf.mem == NULL)
+    vt_error();
+
+  if(lseek(gen->spillfd, 0, SEEK_SET) == (off_t)-1)
+    vt_error_msg("Cannot rewind spill file %s: %s", gen->spillname,
+                 strerror(errno));
+
+  /* write entries of the spilled buffers in the order of their flushes */
+  while(VTGen_spill_read(gen, &length, sizeof(length)))
+  {
+    if(!VTGen_spill_read(gen, buf.mem, (size_t)length))
+      vt_error_msg("Unexpected end of spill file %s", gen->spillname);
+
+    buf.pos = buf.mem + length;
+    buf.size = (size_t)length;
+    buf.ispacked = gen->ispacked;
+
+    VTGen_write_buf(gen, &buf, 0, NULL);
+  }
+
+  free(buf.mem);
+
+  /* close and remove spill file */
+  close(gen->spillfd);
+  unlink(gen->spillname);
+
+  vt_cntl_msg(2, "Removed spill file %s", gen->spillname);
+
+  free(gen->spillname);
+  gen->spillname = NULL;
+  gen->spillfd = -1;
+}
+
+/* Buffer pool (VT_BUFFER_POOL):
+   The buffers of all threads share one process-wide memory budget given by
+   VT_BUFFER_SIZE. Each buffer starts with one chunk (VT_BUFFER_POOL_CHUNK)
+   and grows from the pool, if it's full. A buffer will be flushed only if
+   the pool is exhausted; afterwards it shrinks to one chunk again. */
+
+#if defined(VT_HAVE_ATOMICS)
+
+static volatile size_t pool_used = 0;
+
+static size_t VTGen_pool_reserve(size_t bytes, size_t min)
+{
+  size_t budget = vt_env_bsize();
+  size_t used;
+  size_t got;
+
+  do
+  {
+    used = pool_used;
+
+    /* pool exhausted? */
+    if(used >= budget || budget - used < min)
+      return 0;
+
+    got = (budget - used < bytes) ? budget - used : bytes;
+  } while(!VT_ATOMIC_CAS(&pool_used, used, used + got));
+
+  return got;
+}
+
+static void VTGen_pool_release(size_t bytes)
+{
+  (void)VT_ATOMIC_FETCH_SUB(&pool_used, bytes);
+}
+
+static uint8_t VTGen_pool_grow(VTGen* gen)
+{
+  VTBuf* buf = gen->buf;
+  buffer_t mem;
+  size_t chunk = vt_env_buffer_pool_chunk();
+  size_t got;
+
+  /* double the buffer size, but take at least one chunk */
+  got = VTGen_pool_reserve(gen->poolsize, chunk);
+  if(got == 0)
+    return 0;
+
+  mem = (buffer_t)realloc(buf->mem, gen->poolsize + got);
+  if(mem == NULL)
+  {
+    VTGen_pool_release(got);
+    return 0;
+  }
+
+  /* relocate buffer positions */
+  buf->pos = mem + (buf->pos - buf->mem);
+  if(gen->rewindmark.pos != (buffer_t)-1)
+    gen->rewindmark.pos = mem + (gen->rewindmark.pos - buf->mem);
+  buf->mem = mem;
+
+  gen->poolsize += got;
+  buf->size =
+    gen->poolsize - (2 * VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)));
+
+  vt_cntl_msg(3, "Buffer [id %x] grown to %lu bytes", gen->tid+1,
+              (unsigned long)gen->poolsize);
+
+  return 1;
+}
+
+static void VTGen_pool_shrink(VTGen* gen)
+{
+  VTBuf* buf = gen->buf;
+  buffer_t mem;
+  size_t chunk = vt_env_buffer_pool_chunk();
+
+  /* shrink only, if the buffer holds nothing but the end of the flush */
+  if(gen->poolsize <= chunk || (size_t)(buf->pos - buf->mem) > chunk / 2)
+    return;
+
+  mem = (buffer_t)realloc(buf->mem, chunk);
+  if(mem == NULL)
+    return;
+
+  buf->pos = mem + (buf->pos - buf->mem);
+  buf->mem = mem;
+
+  VTGen_pool_release(gen->poolsize - chunk);
+
+  gen->poolsize = chunk;
+  buf->size =
+    gen->poolsize - (2 * VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)));
+}
+
+#endif /* VT_HAVE_ATOMICS */
+
+/* Flight recorder mode (VT_FLIGHT_RECORDER):
+   If the buffer is full, the older half of the event records will be
+   dropped instead of flushing the buffer (definition records are kept in
+   a separate buffer).
+   Regions which are open at the cut will be re-entered at the time of the
+   last dropped record, so the remaining records are properly nested.
+   BEGIN records of file and collective operations which are still open
+   at the cut, END records whose BEGIN was written before, and summary
+   records are kept and moved to the begin of the buffer.
+   The buffer is written on request (VT_BUFFER_FLUSH, dump signal) and at
+   the end of the program. */
+
+static volatile sig_atomic_t ring_dump_requests = 0;
+
+static buffer_t VTGen_ring_next(VTGen* gen, buffer_t p, buffer_t* rec,
+                                VTBuf_Entry_EnterLeave* unpacked,
+                                uint64_t* ptime)
+{
+  if(gen->ispacked)
+  {
+    if(*p != VTGEN_PACKED_TAG_FULL)
+    {
+      *rec = (buffer_t)unpacked;
+      return VTGen_unpack_EnterLeave(p, ptime, unpacked);
+    }
+
+    p = VTGEN_PACKED_ALIGN(gen->buf, p + 1);
+  }
+
+  *rec = p;
+  return p + ((VTBuf_Entry_Base*)p)->length;
+}
+
+static buffer_t VTGen_ring_copy(VTGen* gen, buffer_t dest, buffer_t rec)
+{
+  uint32_t length = ((VTBuf_Entry_Base*)rec)->length;
+
+  if(gen->ispacked)
+  {
+    *dest = VTGEN_PACKED_TAG_FULL;
+    dest = VTGEN_PACKED_ALIGN(gen->buf, dest + 1);
+  }
+
+  if(dest != rec)
+    memmove(dest, rec, length);
+
+  return dest + length;
+}
+
+static buffer_t VTGen_ring_put(VTGen* gen, buffer_t dest, uint64_t* ptime,
+                               VTBuf_EntryTypes type, uint64_t time,
+                               uint32_t rid, uint32_t sid)
+{
+  VTBuf_Entry_EnterLeave* entry;
+
+  if(gen->ispacked)
+  {
+    return VTGen_pack_EnterLeave(dest, ptime,
+             (type == BUF_ENTRY_TYPE__Enter) ? VTGEN_PACKED_TAG_ENTER :
+                                               VTGEN_PACKED_TAG_LEAVE,
+             time, rid, sid);
+  }
+
+  entry = (VTBuf_Entry_EnterLeave*)dest;
+
+  entry->type   = type;
+  entry->length = VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave));
+  entry->time   = time;
+  entry->rid    = rid;
+  entry->sid    = sid;
+
+  return dest + entry->length;
+}
+
+/* keep a record of the dropped part of the buffer */
+static void VTGen_ring_keep(VTGen* gen, buffer_t rec)
+{
+  uint32_t length = ((VTBuf_Entry_Base*)rec)->length;
+
+  if(gen->ringkeeplen + length > gen->ringkeepsize)
+  {
+    gen->ringkeepsize = gen->ringkeepsize ? 2 * gen->ringkeepsize : 0x1000;
+    if(gen->ringkeepsize < gen->ringkeeplen + length)
+      gen->ringkeepsize = gen->ringkeeplen + length;
+    gen->ringkeep = (buffer_t)realloc(gen->ringkeep, gen->ringkeepsize);
+    if(gen->ringkeep == NULL)
+      vt_error();
+  }
+
+  memcpy(gen->ringkeep + gen->ringkeeplen, rec, length);
+  gen->ringkeeplen += length;
+  gen->ringkeepnum++;
+}
+
+/* remove the kept BEGIN record of type `type' with matching id `mid';
+   returns 0, if there is none */
+static uint8_t VTGen_ring_unkeep(VTGen* gen, VTBuf_EntryTypes type,
+                                 uint64_t mid)
+{
+  buffer_t p = gen->ringkeep;
+  buffer_t end = gen->ringkeep + gen->ringkeeplen;
+
+  while(p < end)
+  {
+    uint32_t length = ((VTBuf_Entry_Base*)p)->length;
+
+    if(((VTBuf_Entry_Base*)p)->type == type &&
+       ((type == BUF_ENTRY_TYPE__BeginFileOperation) ?
+        ((VTBuf_Entry_BeginFileOperation*)p)->mid :
+        ((VTBuf_Entry_BeginCollectiveOperation*)p)->mid) == mid)
+    {
+      memmove(p, p + length, (size_t)(end - (p + length)));
+      gen->ringkeeplen -= length;
+      gen->ringkeepnum--;
+      return 1;
+    }
+
+    p += length;
+  }
+
+  return 0;
+}
+
+static void VTGen_ring_drop(VTGen* gen)
+{
+  VTBuf* buf = gen->buf;
+  VTBuf_Entry_EnterLeave unpacked;
+  VTBuf_Entry_EnterLeave* entry;
+  buffer_t p, next, rec, dest;
+  uint64_t ptime = 0;
+  uint64_t dest_ptime = 0;
+  uint64_t cut_time = 0;
+  uint32_t depth = 0;
+  uint32_t i;
+  size_t half = (size_t)(buf->pos - buf->mem) / 2;
+  size_t enter_length = gen->ispacked ? VTGEN_PACKED_MAX_LENGTH :
+    VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave));
+
+/* space needed for the kept records and the re-entered regions */
+#define RING_HEAD_LENGTH                                            \
+  (gen->ringkeeplen + gen->ringkeepnum * VTGEN_PACKED_HDR_LENGTH(gen) + \
+   depth * enter_length)
+
+  p = dest = buf->mem;
+  gen->ringkeeplen = 0;
+  gen->ringkeepnum = 0;
+
+  /* run over the older half of the buffer; drop event records, track
+     open regions and operations, and keep summary records */
+  while(p < buf->pos &&
+        ((size_t)(p - buf->mem) < half ||
+         (size_t)(p - dest) < RING_HEAD_LENGTH + VTGEN_RING_SLACK))
+  {
+    next = VTGen_ring_next(gen, p, &rec, &unpacked, &ptime);
+    entry = (VTBuf_Entry_EnterLeave*)rec;
+
+    /* all event records have their time at the same position */
+    cut_time = entry->time;
+
+    switch(entry->type)
+    {
+      case BUF_ENTRY_TYPE__Enter:
+      {
+        if(depth == gen->ringstacksize)
+        {
+          gen->ringstacksize = gen->ringstacksize ? 2 * gen->ringstacksize : 64;
+          gen->ringstack =
+            (VTRingRegion*)realloc(gen->ringstack,
+                                   gen->ringstacksize * sizeof(VTRingRegion));
+          if(gen->ringstack == NULL)
+            vt_error();
+        }
+        gen->ringstack[depth].rid = entry->rid;
+        gen->ringstack[depth].sid = entry->sid;
+        depth++;
+        break;
+      }
+      case BUF_ENTRY_TYPE__Leave:
+      {
+        /* LEAVE of a region entered before the last dump? */
+        if(depth > 0) depth--;
+        break;
+      }
+      case BUF_ENTRY_TYPE__BeginFileOperation:
+      case BUF_ENTRY_TYPE__BeginCollectiveOperation:
+      case BUF_ENTRY_TYPE__FunctionSummary:
+      case BUF_ENTRY_TYPE__MessageSummary:
+      case BUF_ENTRY_TYPE__CollectiveOperationSummary:
+      case BUF_ENTRY_TYPE__FileOperationSummary:
+      {
+        VTGen_ring_keep(gen, rec);
+        break;
+      }
+      case BUF_ENTRY_TYPE__EndFileOperation:
+      {
+        /* drop the operation, if its BEGIN is dropped as well; keep the
+           END, if the BEGIN was written before the last dump */
+        if(!VTGen_ring_unkeep(gen, BUF_ENTRY_TYPE__BeginFileOperation,
+                              ((VTBuf_Entry_EndFileOperation*)rec)->mid))
+          VTGen_ring_keep(gen, rec);
+        break;
+      }
+      case BUF_ENTRY_TYPE__EndCollectiveOperation:
+      {
+        if(!VTGen_ring_unkeep(gen, BUF_ENTRY_TYPE__BeginCollectiveOperation,
+                              ((VTBuf_Entry_EndCollectiveOperation*)rec)->mid))
+          VTGen_ring_keep(gen, rec);
+        break;
+      }
+      default:
+        break;
+    }
+
+    p = next;
+  }
+
+  if((size_t)(buf->mem + buf->size - dest) < RING_HEAD_LENGTH)
+    vt_error_msg("Call stack too deep or too many open operations for the "
+                 "flight recorder buffer; increase VT_BUFFER_SIZE");
+
+#undef RING_HEAD_LENGTH
+
+  /* move kept records to the begin of the buffer; their times don't
+     exceed the time of the re-entered regions */
+  for(rec = gen->ringkeep; rec < gen->ringkeep + gen->ringkeeplen;
+      rec += ((VTBuf_Entry_Base*)rec)->length)
+    dest = VTGen_ring_copy(gen, dest, rec);
+
+  /* re-enter regions which are open at the cut */
+  for(i = 0; i < depth; i++)
+  {
+    dest = VTGen_ring_put(gen, dest, &dest_ptime, BUF_ENTRY_TYPE__Enter,
+                          cut_time, gen->ringstack[i].rid,
+                          gen->ringstack[i].sid);
+  }
+
+  /* shift remaining records */
+  while(p < buf->pos)
+  {
+    next = VTGen_ring_next(gen, p, &rec, &unpacked, &ptime);
+
+    if(rec == (buffer_t)&unpacked)
+    {
+      dest = VTGen_ring_put(gen, dest, &dest_ptime, unpacked.type,
+                            unpacked.time, unpacked.rid, unpacked.sid);
+    }
+    else
+    {
+      dest = VTGen_ring_copy(gen, dest, rec);
+    }
+
+    p = next;
+  }
+
+  vt_cntl_msg(3, "Dropped %lu bytes of flight recorder buffer [id %x]",
+              (unsigned long)(buf->pos - dest), gen->tid+1);
+
+  buf->pos = dest;
+  buf->ptime = dest_ptime;
+
+  /* records behind the rewind mark may be dropped */
+  gen->rewindmark.time = 0;
+  gen->rewindmark.pos = (buffer_t)-1;
+}
+
+/* Allocate the event buffers; this is deferred to the first event record
+   of the thread, so threads which never record an event don't hold a
+   buffer */
+
+static void VTGen_alloc_bufs(VTGen* gen)
+{
+  uint32_t i;
+
+#if defined(VT_HAVE_ATOMICS)
+  /* each buffer gets one chunk, even if the pool is exhausted */
+  if(gen->ispool)
+  {
+    gen->poolsize = gen->bufsize;
+    (void)VT_ATOMIC_FETCH_ADD(&pool_used, gen->bufsize);
+  }
+#endif /* VT_HAVE_ATOMICS */
+
+  for(i = 0; i < gen->bufn; i++)
+  {
+    VTBuf* buf = gen->bufv[i];
+
+    buf->mem = malloc(gen->bufsize);
+    if(buf->mem == NULL)
+      vt_error();
+
+    buf->pos  = buf->mem;
+    /* subtraction leaves space for size of FLUSH record */
+    buf->size =
+      gen->bufsize - (2 * VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)));
+  }
+
+  /* a rewind mark set before refers to the begin of the buffer */
+  if(gen->rewindmark.pos != (buffer_t)-1)
+    gen->rewindmark.pos = gen->buf->mem;
+
+  vt_cntl_msg(3, "Allocated %u buffer(s) [id %x] of %lu bytes", gen->bufn,
+              gen->tid+1, (unsigned long)gen->bufsize);
+}
+
+/* Open the summary generator at its first record */
+
+static VTSum* VTGen_open_sum(VTGen* gen)
+{
+  gen->sum = VTSum_open(gen, gen->tid);
+  return gen->sum;
+}
+
+/* Make room for a record of the given size in the event buffer; returns
+   with room for it, unless the maximum number of flushes is reached */
+
+static void VTGen_buffer_full(VTGen* gen, size_t bytes, uint64_t flushBTime,
+                              uint64_t* flushETime)
+{
+  /* allocate buffers at the first event record */
+  if(gen->buf->mem == NULL)
+  {
+    VTGen_alloc_bufs(gen);
+    if(VTGEN_EVENT_FITS(gen, bytes))
+      return;
+  }
+
+  /* the buffer will be moved or rearranged */
+  gen->shortend = NULL;
+
+#if defined(VT_HAVE_ATOMICS)
+  /* grow buffer, if the pool isn't exhausted; the pool may hand out less
+     than the record needs, so it may take several steps */
+  if(gen->ispool)
+  {
+    while(!VTGEN_EVENT_FITS(gen, bytes) && VTGen_pool_grow(gen));
+    if(VTGEN_EVENT_FITS(gen, bytes))
+      return;
+  }
+#endif /* VT_HAVE_ATOMICS */
+
+  if(gen->isring)
+  {
+    /* drop older event records, if no dump was requested */
+    if(gen->ringdumps == (uint32_t)ring_dump_requests)
+    {
+      VTGen_ring_drop(gen);
+
+      /* done, unless the buffer is filled by the re-entered regions */
+      if((size_t)(gen->buf->pos - gen->buf->mem) <= gen->buf->size / 2 &&
+         VTGEN_EVENT_FITS(gen, bytes))
+        return;
+    }
+
+    gen->ringdumps = (uint32_t)ring_dump_requests;
+  }
+
+  VTGen_flush(gen, 0, flushBTime, flushETime);
+  if(gen->flushcntr == 0)
+    return;
+
+#if defined(VT_HAVE_ATOMICS)
+  /* give buffer space back to the pool, but keep room for the record */
+  if(gen->ispool)
+  {
+    VTGen_pool_shrink(gen);
+    while(!VTGEN_EVENT_FITS(gen, bytes) && VTGen_pool_grow(gen));
+  }
+#endif /* VT_HAVE_ATOMICS */
+
+  /* even an empty buffer is too small */
+  if(!VTGEN_EVENT_FITS(gen, bytes))
+  {
+    vt_error_msg("Trace buffer too small for a record of %lu bytes; "
+                 "increase VT_BUFFER_SIZE", (unsigned long)bytes);
+  }
+}
+
+void VTGen_request_dump()
+{
+  ring_dump_requests++;
+}
+
+static void VTGen_grow_defbuf(VTGen* gen, size_t bytes)
+{
+  VTBuf* buf = gen->defbuf;
+  size_t used = (size_t)(buf->pos - buf->mem);
+  size_t size = buf->size;
+  buffer_t mem;
+
+  if(size == 0)
+    size = VTGEN_DEFBUF_SIZE;
+  while(used + bytes > size)
+    size *= 2;
+
+  mem = (buffer_t)realloc(buf->mem, size);
+  if(mem == NULL)
+    vt_error();
+
+  buf->mem  = mem;
+  buf->pos  = mem + used;
+  buf->size = size;
+
+  vt_cntl_msg(3, "Definition buffer [id %x] grown to %lu bytes",
+              gen->tid+1, (unsigned long)size);
+}
+
+static void VTGen_free_bufs(VTGen* gen)
+{
+  uint32_t i;
+
+  for (i = 0; i < gen->bufn; i++)
+  {
+    /* free buffer memory */
+    free(gen->bufv[i]->mem);
+
+    /* free buffer record */
+    free(gen->bufv[i]);
+  }
+
+  /* free vector of buffer records */
+  free(gen->bufv);
+
+  /* free definition buffer */
+  free(gen->defbuf->mem);
+  free(gen->defbuf);
+
+#if defined(VT_HAVE_ATOMICS)
+  /* give buffer space back to the pool */
+  if (gen->ispool)
+    VTGen_pool_release(gen->poolsize);
+#endif /* VT_HAVE_ATOMICS */
+
+  /* free stack of open regions and kept records of the flight recorder */
+  if (gen->ringstack != NULL)
+    free(gen->ringstack);
+  if (gen->ringkeep != NULL)
+    free(gen->ringkeep);
+
+  gen->buf = NULL;
+  gen->bufv = NULL;
+  gen->bufn = 0;
+  gen->defbuf = NULL;
+}
+
+VTGen* VTGen_open(const char* tname, const char* tnamesuffix,
+                  uint32_t ptid, uint32_t tid, size_t buffer_size)
+{
+  VTGen* gen;
+  char* ldir = vt_env_ldir();
+  char* gdir = vt_env_gdir();
+  uint32_t i;
+
+  /* check write permissions */
+
+  if (vt_env_ldir_check())
+  {
+    if (access(ldir, W_OK) != 0)
+      vt_error_msg("Cannot access %s: Permission denied", ldir);
+  }
+  if (vt_env_gdir_check())
+  {
+    if (access(gdir, W_OK) != 0)
+      vt_error_msg("Cannot access %s: Permission denied", gdir);
+  }
+
+  /* allocate VTGen record */
+  gen = (VTGen*)calloc(1, sizeof(VTGen));
+  if (gen == NULL)
+    vt_error();
+
+  /* store thread name */
+  gen->tname = tname;
+
+  /* store thread name suffix */
+  gen->tnamesuffix = tnamesuffix;
+
+  /* store parent thread id */
+  gen->ptid = ptid;
+
+  /* store thread id */
+  gen->tid = tid;
+
+  /* initialize flush counter */
+  gen->flushcntr = vt_env_max_flushes();
+  if( gen->flushcntr == 0 ) gen->flushcntr = (uint32_t)-1;
+
+  /* initialize first flush flag */
+  gen->isfirstflush = 1;
+
+  /* initialize trace mode flags */
+  gen->mode = (uint8_t)vt_env_mode();
+
+  /* initialize statistics properties */
+  gen->sum_props = (uint8_t)vt_env_stat_props();
+
+  /* initialize packed buffer format flag */
+  gen->ispacked = (uint8_t)vt_env_buffer_packed();
+
+  /* initialize min. duration of recorded calls (in ticks) */
+  gen->minduration =
+    (uint64_t)vt_env_min_duration() * vt_pform_clockres() / 1000000;
+
+  /* initialize flight recorder mode flag */
+  gen->isring = (uint8_t)vt_env_flight_recorder();
+  gen->ringdumps = (uint32_t)ring_dump_requests;
+
+  /* the VTSum record is allocated at the first summary record
+     (see VTGEN_SUM) */
+  gen->sum = NULL;
+
+  /* get number of buffers */
+
+  gen->bufn = 1;
+
+#if defined(VTGEN_ASYNC_FLUSH)
+  gen->isasync = (uint8_t)vt_env_async_flush();
+  if (gen->isasync)
+  {
+    /* the buffers share the space given by buffer_size */
+    gen->bufn = (uint32_t)vt_env_async_flush_bufs();
+    buffer_size /= gen->bufn;
+  }
+#else /* VTGEN_ASYNC_FLUSH */
+  if (tid == 0 && vt_env_async_flush())
+    vt_warning("Asynchronous buffer flushes are not supported by this "
+               "library; ignoring VT_ASYNC_FLUSH");
+#endif /* VTGEN_ASYNC_FLUSH */
+
+  /* take buffer from the pool, if desired */
+
+  if (vt_env_buffer_pool())
+  {
+#if defined(VT_HAVE_ATOMICS)
+    if (gen->bufn == 1)
+    {
+      gen->ispool = 1;
+
+      /* the buffer starts with one chunk (see VTGen_alloc_bufs) */
+      buffer_size = vt_env_buffer_pool_chunk();
+    }
+    else if (tid == 0)
+    {
+      vt_warning("VT_BUFFER_POOL has no effect if VT_ASYNC_FLUSH is set");
+    }
+#else /* VT_HAVE_ATOMICS */
+    if (tid == 0)
+      vt_warning("Buffer pool is not supported by this library; "
+                 "ignoring VT_BUFFER_POOL");
+#endif /* VT_HAVE_ATOMICS */
+  }
+
+  /* allocate vector of buffer records */
+
+  gen->bufv = (VTBuf**)calloc(gen->bufn, sizeof(VTBuf*));
+  if (gen->bufv == NULL)
+    vt_error();
+
+  for (i = 0; i < gen->bufn; i++)
+  {
+    /* allocate buffer record; the buffer itself is allocated at the first
+       event record (see VTGen_alloc_bufs) */
+
+    gen->bufv[i] = (VTBuf*)calloc(1, sizeof(VTBuf));
+    if (gen->bufv[i] == NULL)
+      vt_error();
+
+    gen->bufv[i]->ispacked = gen->ispacked;
+
+#if defined(VTGEN_ASYNC_FLUSH)
+    gen->bufv[i]->gen = gen;
+#endif /* VTGEN_ASYNC_FLUSH */
+  }
+
+  gen->bufsize = buffer_size;
+
+  /* start filling the first buffer */
+  gen->buf = gen->bufv[0];
+
+  /* allocate definition buffer record; the buffer is allocated at the
+     first definition record and grows on demand */
+
+  gen->defbuf = (VTBuf*)calloc(1, sizeof(VTBuf));
+  if (gen->defbuf == NULL)
+    vt_error();
+
+#if defined(VTGEN_ASYNC_FLUSH)
+  /* start writer thread, if necessary */
+  if (gen->isasync)
+    VTGen_async_attach();
+#endif /* VTGEN_ASYNC_FLUSH */
+
+  /* initialize raw spill file */
+  gen->isspill = (uint8_t)vt_env_raw_spill();
+  gen->spillfd = -1;
+
+#if defined(VTGEN_ASYNC_FLUSH)
+  /* the writer thread already takes the conversion off the application
+     thread */
+  if (gen->isspill && gen->isasync)
+  {
+    if (tid == 0)
+      vt_warning("VT_RAW_SPILL has no effect if VT_ASYNC_FLUSH is set");
+    gen->isspill = 0;
+  }
+#endif /* VTGEN_ASYNC_FLUSH */
+
+  /* initialize rewind mark */
+  gen->rewindmark.pos = (buffer_t)-1;
+
+  /* return */
+  return gen;
+}
+
+void VTGen_flush(VTGen* gen, uint8_t lastFlush,
+                 uint64_t flushBTime, uint64_t* flushETime )
+{
+  uint64_t ovhd_time;
+
+  /* intermediate flush of a thread without any event record yet? (its
+     buffers aren't allocated, see VTGen_alloc_bufs) */
+  if(!lastFlush && gen->buf->mem == NULL) return;
+
+  /* intermediate flush and max. buffer flushes reached? */
+  if(!lastFlush && gen->flushcntr == 0) return;
+
+  /* the last ENTER record can't be retracted after flushing */
+  gen->shortend = NULL;
+
+  /* reset buffers, if rank is disabled */
+  if(vt_my_trace_is_disabled)
+  {
+    gen->buf->pos = gen->buf->mem;
+    gen->buf->ptime = 0;
+    gen->defbuf->pos = gen->defbuf->mem;
+    return;
+  }
+
+  /* the checks above are not accounted, so every path from here on
+     reaches VT_OVHD_END */
+  ovhd_time = VT_OVHD_BEGIN();
+
+  /* disable I/O tracing */
+  VT_SUSPEND_IO_TRACING(gen->tid);
+
+  /* mark begin of flush */
+  if(!lastFlush)
+    vt_enter_flush(gen->tid, &flushBTime);
+
+  if(gen->isfirstflush)
+  {
+    /* set base name of the temporary files (basename includes local path
+       but neither thread identifier nor suffix) */
+
+    gen->fileprefix = (char*)calloc(VT_PATH_MAX + 1, sizeof(char));
+    if(gen->fileprefix == NULL)
+      vt_error();
+
+    snprintf(gen->fileprefix, VT_PATH_MAX, "%s/%s.%lx.%u",
+             vt_env_ldir(), vt_env_fprefix(),
+             vt_pform_node_id(), getpid());
+
+    /* open file manager for writer stream */
+    gen->filemanager = OTF_FileManager_open(4);
+
+    /* open writer stream */
+    gen->filestream = OTF_WStream_open(gen->fileprefix, gen->tid+1,
+                                       gen->filemanager);
+
+    if( gen->filestream == NULL )
+      vt_error_msg("Cannot open OTF writer stream [namestub %s id %x]",
+                   gen->fileprefix, gen->tid+1); 
+    else
+      vt_cntl_msg(2, "Opened OTF writer stream [namestub %s id %x] for "
+                     "generation [buffer %d bytes]", 
+                     gen->fileprefix, gen->tid+1, gen->buf->size);
+
+    /* set file compression */
+
+    if( vt_env_compression() )
+    {
+      gen->filecomp = OTF_FILECOMPRESSION_COMPRESSED;
+      if( vt_env_compression_level() > 0 )
+        gen->filecomp = (OTF_FileCompression)vt_env_compression_level();
+
+      if( !OTF_WStream_setCompression(gen->filestream, gen->filecomp) )
+        gen->filecomp = OTF_FILECOMPRESSION_UNCOMPRESSED;
+    }
+    else
+    {
+      gen->filecomp = OTF_FILECOMPRESSION_UNCOMPRESSED;
+    }
+
+    if( gen->tid == 0 )
+    {
+      char creator[100];
+      uint64_t res = vt_pform_clockres();
+
+      /* write creator record */
+
+      snprintf(creator, sizeof(creator) - 1,
+               "%s", PACKAGE_STRING);
+
+      OTF_WStream_writeOtfVersion( gen->filestream );
+      OTF_WStream_writeDefCreator( gen->filestream, creator );
+
+      /* write timer resolution record */
+
+      OTF_WStream_writeDefTimerResolution( gen->filestream, res );
+    }
+
+    /* write process definition record */
+    {
+      uint32_t ptid = 0;
+      char pname[1024];
 
-         OTF_WStream_writeRMAPutRemoteEnd(gen->filestream,
-                                          entry->time,
-                                          65536 * gen->tid + vt_my_trace + 1,
-                                          entry->opid,
-                                          entry->tpid,
-                                          entry->cid,
-                                          entry->tag,
-                                          entry->len,
-                                          entry->sid);
-          break;
-       }
-       case BUF_ENTRY_TYPE__RMAGet:
-       {
-         VTBuf_Entry_RMAPutGet* entry = (VTBuf_Entry_RMAPutGet*)p;
+      if(gen->tid != 0)
+        ptid = 65536 * gen->ptid + vt_my_trace + 1;
 
-         OTF_WStream_writeRMAGet(gen->filestream,
-                                 entry->time,
-                                 65536 * gen->tid + vt_my_trace + 1,
-                                 entry->opid,
-                                 entry->tpid,
-                                 entry->cid,
-                                 entry->tag,
-                                 entry->len,
-                                 entry->sid);
-         break;
-       }
-       case BUF_ENTRY_TYPE__RMAEnd:
-       {
-         VTBuf_Entry_RMAEnd* entry = (VTBuf_Entry_RMAEnd*)p;
+      snprintf(pname, sizeof(pname) - 1, "%s %d%s",
+               gen->tname, vt_my_trace, gen->tnamesuffix);
 
-         OTF_WStream_writeRMAEnd(gen->filestream,
-                                 entry->time,
-                                 65536 * gen->tid + vt_my_trace + 1,
-                                 entry->rpid,
-                                 entry->cid,
-                                 entry->tag,
-                                 entry->sid);
-         break;
-       }
-       case BUF_ENTRY_TYPE__FunctionSummary:
-       {
-         VTBuf_Entry_FunctionSummary* entry =
-           (VTBuf_Entry_FunctionSummary*)p;
+      OTF_WStream_writeDefProcess(gen->filestream,
+                                  65536 * gen->tid + vt_my_trace + 1,
+                                  pname, ptid);
+    }
 
-         OTF_WStream_writeFunctionSummary(gen->filestream,
-           entry->time,
-           entry->rid,
-           65536 * gen->tid + vt_my_trace + 1,
-           entry->cnt,
-           entry->excl,
-           entry->incl);
+    /* write process group definition record (node name) */
+    {
+       uint32_t pid = 65536 * gen->tid + vt_my_trace + 1;
+       char pgname[100];
 
-         break;
-       }
-       case BUF_ENTRY_TYPE__MessageSummary:
-       {
-         VTBuf_Entry_MessageSummary* entry =
-           (VTBuf_Entry_MessageSummary*)p;
+       snprintf(pgname, sizeof(pgname) - 1, "__NODE__ %s",
+                vt_pform_node_name());
 
-         OTF_WStream_writeMessageSummary(gen->filestream,
-           entry->time,
-           65536 * gen->tid + vt_my_trace + 1,
-           entry->peer,
-           entry->cid,
-           entry->tag,
-           entry->scnt,
-           entry->rcnt,
-           entry->sent,
-           entry->recvd);
+       OTF_WStream_writeDefProcessGroup(gen->filestream,
+                                        0, /* id will be given by vtunify */
+                                        pgname, 1, &pid);
+    }
 
-         break;
-       }
-       case BUF_ENTRY_TYPE__CollectiveOperationSummary:
-       {
-         VTBuf_Entry_CollectiveOperationSummary* entry =
-           (VTBuf_Entry_CollectiveOperationSummary*)p;
+    gen->isfirstflush = 0;
+  }
 
-         OTF_WStream_writeCollopSummary(gen->filestream,
-                                        entry->time,
-                                        65536 * gen->tid + vt_my_trace + 1,
-                                        entry->cid,
-                                        entry->rid,
-                                        entry->scnt,
-                                        entry->rcnt,
-                                        entry->sent,
-                                        entry->recvd);
-         break;
-       }
-       case BUF_ENTRY_TYPE__FileOperationSummary:
-       {
-         VTBuf_Entry_FileOperationSummary* entry =
-           (VTBuf_Entry_FileOperationSummary*)p;
+#if defined(VTGEN_ASYNC_FLUSH)
+  if(gen->isasync)
+  {
+    if(!lastFlush)
+    {
+      /* hand over the filled buffer to the writer thread and continue
+         with a spare one */
+      VTGen_async_handoff(gen);
 
-         OTF_WStream_writeFileOperationSummary(gen->filestream,
-           entry->time,
-           entry->fid,
-           65536 * gen->tid + vt_my_trace + 1,
-           entry->nopen,
-           entry->nclose,
-           entry->nread,
-           entry->nwrite,
-           entry->nseek,
-           entry->read,
-           entry->wrote);
+      /* mark end of flush, if max flushes not reached */
+      if(gen->flushcntr > 1)
+      {
+        uint64_t flush_etime = vt_pform_wtime();
+        vt_exit_flush(gen->tid, &flush_etime);
+        if( flushETime != NULL ) *flushETime = flush_etime;
+      }
+    }
+    else
+    {
+      /* wait until the writer thread has written all buffers handed over
+         so far, in order to keep the records in chronological order */
+      VTGen_async_drain(gen);
+    }
+  }
 
-         break;
-       }
-       default:
-       {
-         vt_assert(0);
-       }
-     }
+  if(!gen->isasync || lastFlush)
+#endif /* VTGEN_ASYNC_FLUSH */
+  {
+    /* write definition records (with asynchronous flushes at the last
+       flush only, because the writer thread owns the stream until then) */
+    if(gen->defbuf->pos > gen->defbuf->mem)
+    {
+      VTGen_write_buf(gen, gen->defbuf, 0, NULL);
+      gen->defbuf->pos = gen->defbuf->mem;
+    }
 
-     /* last buffer entry and end flush not marked ? */
-     if(!end_flush_marked &&
-        p + ((VTBuf_Entry_Base*)p)->length >= gen->buf->pos)
-     {
-       /* mark end of flush, if it's not the last (invisible) flush and
-          max flushes not reached */
-       if(!lastFlush && gen->flushcntr > 1)
-       {
-         uint64_t flush_etime = vt_pform_wtime();
-         vt_exit_flush(gen->tid, &flush_etime);
-         if( flushETime != NULL ) *flushETime = flush_etime;
-       }
+    if(gen->isspill && !lastFlush)
+    {
+      /* append raw buffer entries to the spill file */
+      VTGen_spill_buf(gen, gen->buf);
 
-       end_flush_marked = 1;
-     }
+      /* reset buffer */
+      gen->buf->pos = gen->buf->mem;
+      gen->buf->ptime = 0;
 
-     p += ((VTBuf_Entry_Base*)p)->length;
+      /* mark end of flush, if max flushes not reached */
+      if(gen->flushcntr > 1)
+      {
+        uint64_t flush_etime = vt_pform_wtime();
+        vt_exit_flush(gen->tid, &flush_etime);
+        if( flushETime != NULL ) *flushETime = flush_etime;
+      }
+    }
+    else
+    {
+      /* write entries of the spilled buffers first */
+      if(gen->isspill)
+        VTGen_unspill(gen);
+
+      /* write buffer entries; mark end of flush, if it's not the last
+         (invisible) flush and max flushes not reached */
+      VTGen_write_buf(gen, gen->buf, (!lastFlush && gen->flushcntr > 1),
+                      flushETime);
+
+      /* reset buffer */
+      gen->buf->pos = gen->buf->mem;
+      gen->buf->ptime = 0;
+    }
   }
 
   /* if it's the last flush write event/summary comment record, in order that
@@ -1291,9 +2615,6 @@ void VTGen_flush(VTGen* gen, uint8_t lastFlush,
     }
   }
 
-  /* reset buffer */
-  gen->buf->pos = gen->buf->mem;
-
   vt_cntl_msg(2, "Flushed OTF writer stream [namestub %s id %x]",
               gen->fileprefix, gen->tid+1);
 
@@ -1320,17 +2641,25 @@ void VTGen_flush(VTGen* gen, uint8_t lastFlush,
 
   /* enable I/O tracing again */
   VT_RESUME_IO_TRACING(gen->tid);
+
+  VT_OVHD_END(VTThrdv[gen->tid], VT_OVHD_FLUSH, ovhd_time);
 }
 
 void VTGen_close(VTGen* gen)
 {
-  /* close summary */
-  if (VTGEN_IS_SUM_ON(gen))
+  /* close summary, if any summary record was written */
+  if (gen->sum != NULL)
     VTSum_close(gen->sum);
 
   /* flush buffer if necessary */
   VTGen_flush(gen, 1, 0, NULL);
 
+#if defined(VTGEN_ASYNC_FLUSH)
+  /* terminate writer thread, if necessary */
+  if (gen->isasync)
+    VTGen_async_detach();
+#endif /* VTGEN_ASYNC_FLUSH */
+
   if(gen->fileprefix)
   {
     /* close writer stream */
@@ -1343,11 +2672,8 @@ void VTGen_close(VTGen* gen)
                 gen->fileprefix, gen->tid+1);
   }
 
-  /* free buffer memory */
-  free(gen->buf->mem); 
-
-  /* free buffer record */
-  free(gen->buf); 
+  /* free buffers */
+  VTGen_free_bufs(gen);
 }
 
 void VTGen_delete(VTGen* gen)
@@ -1494,7 +2820,7 @@ void VTGen_delete(VTGen* gen)
   }
 
   /* delete sum record */
-  if (VTGEN_IS_SUM_ON(gen)) VTSum_delete(gen->sum);
+  if (gen->sum != NULL) VTSum_delete(gen->sum);
 
   /* free gen record */
   free(gen);
@@ -1502,6 +2828,17 @@ void VTGen_delete(VTGen* gen)
 
 void VTGen_destroy(VTGen* gen)
 {
+#if defined(VTGEN_ASYNC_FLUSH)
+  /* wait for buffers in flight and terminate writer thread, if necessary
+     (in a forked child, VTGen_async_atfork_child has already detached the
+     generator from the parent's writer thread) */
+  if (gen->isasync)
+  {
+    VTGen_async_drain(gen);
+    VTGen_async_detach();
+  }
+#endif /* VTGEN_ASYNC_FLUSH */
+
   if(gen->fileprefix)
   {
     /* close writer stream */
@@ -1511,14 +2848,18 @@ void VTGen_destroy(VTGen* gen)
     OTF_FileManager_close(gen->filemanager);
   }
 
-  /* destroy sum record */
-  if (VTGEN_IS_SUM_ON(gen)) VTSum_destroy(gen->sum);
+  /* close spill file; it belongs to the parent process, so don't remove it */
+  if (gen->spillfd != -1)
+  {
+    close(gen->spillfd);
+    free(gen->spillname);
+  }
 
-  /* free buffer memory */
-  free(gen->buf->mem); 
+  /* destroy sum record */
+  if (gen->sum != NULL) VTSum_destroy(gen->sum);
 
-  /* free buffer record */
-  free(gen->buf); 
+  /* free buffers */
+  VTGen_free_bufs(gen);
 
   /* free gen record */
   free(gen); 
@@ -1528,6 +2869,12 @@ uint8_t VTGen_get_buflevel(VTGen* gen)
 {
   VTGEN_CHECK(gen);
 
+  /* the flight recorder buffer never needs to be flushed */
+  if (gen->isring) return 0;
+
+  /* no buffer allocated yet */
+  if (gen->buf->size == 0) return 0;
+
   return (uint8_t)(((gen->buf->pos - gen->buf->mem) * 100) / gen->buf->size);
 }
 
@@ -1549,13 +2896,13 @@ void VTGen_write_DEFINITION_COMMENT(VTGen* gen, const char* comment)
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefinitionComment*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefinitionComment*)gen->defbuf->pos);
 
   new_entry->type    = BUF_ENTRY_TYPE__DefinitionComment;
   new_entry->length  = length;
   strcpy(new_entry->comment, comment);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_SCL_FILE(VTGen* gen,
@@ -1572,14 +2919,14 @@ void VTGen_write_DEF_SCL_FILE(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefSclFile*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefSclFile*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefSclFile;
   new_entry->length = length;
   new_entry->fid    = fid;
   strcpy(new_entry->fname, fname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_SCL(VTGen* gen,
@@ -1596,14 +2943,14 @@ void VTGen_write_DEF_SCL(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefScl*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefScl*)gen->defbuf->pos);
   new_entry->type   = BUF_ENTRY_TYPE__DefScl;
   new_entry->length = length;
   new_entry->sid    = sid;
   new_entry->fid    = fid;
   new_entry->ln     = ln;
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_FILE_GROUP(VTGen* gen,
@@ -1620,14 +2967,14 @@ void VTGen_write_DEF_FILE_GROUP(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefFileGroup*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefFileGroup*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefFileGroup;
   new_entry->length = length;
   new_entry->gid    = gid;
   strcpy(new_entry->gname, gname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_FILE(VTGen* gen,
@@ -1645,7 +2992,7 @@ void VTGen_write_DEF_FILE(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefFile*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefFile*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefFile;
   new_entry->length = length;
@@ -1653,7 +3000,7 @@ void VTGen_write_DEF_FILE(VTGen* gen,
   new_entry->gid    = gid;
   strcpy(new_entry->fname, fname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_FUNCTION_GROUP(VTGen* gen,
@@ -1670,14 +3017,14 @@ void VTGen_write_DEF_FUNCTION_GROUP(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefFunctionGroup*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefFunctionGroup*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefFunctionGroup;
   new_entry->length = length;
   new_entry->rdid   = rdid;
   strcpy(new_entry->rdesc, rdesc);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_FUNCTION(VTGen* gen,
@@ -1696,7 +3043,7 @@ void VTGen_write_DEF_FUNCTION(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefFunction*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefFunction*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefFunction;
   new_entry->length = length;
@@ -1705,7 +3052,7 @@ void VTGen_write_DEF_FUNCTION(VTGen* gen,
   new_entry->sid    = sid;
   strcpy(new_entry->rname, rname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_COLLECTIVE_OPERATION(VTGen* gen,
@@ -1723,7 +3070,7 @@ void VTGen_write_DEF_COLLECTIVE_OPERATION(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefCollectiveOperation*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefCollectiveOperation*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefCollectiveOperation;
   new_entry->length = length;
@@ -1731,7 +3078,7 @@ void VTGen_write_DEF_COLLECTIVE_OPERATION(VTGen* gen,
   new_entry->ctype  = ctype;
   strcpy(new_entry->cname, cname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_COUNTER_GROUP(VTGen* gen,
@@ -1748,14 +3095,14 @@ void VTGen_write_DEF_COUNTER_GROUP(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefCounterGroup*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefCounterGroup*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefCounterGroup;
   new_entry->length = length;
   new_entry->gid    = gid;
   strcpy(new_entry->gname, gname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_COUNTER(VTGen* gen,
@@ -1775,7 +3122,7 @@ void VTGen_write_DEF_COUNTER(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefCounter*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefCounter*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefCounter;
   new_entry->length = length;
@@ -1786,7 +3133,7 @@ void VTGen_write_DEF_COUNTER(VTGen* gen,
   new_entry->cunit[sizeof(new_entry->cunit)-1] = '\0';
   strcpy(new_entry->cname, cname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 void VTGen_write_DEF_PROCESS_GROUP(VTGen* gen,
@@ -1805,7 +3152,7 @@ void VTGen_write_DEF_PROCESS_GROUP(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefProcessGroup*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefProcessGroup*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefProcessGroup;
   new_entry->length = length;
@@ -1816,7 +3163,7 @@ void VTGen_write_DEF_PROCESS_GROUP(VTGen* gen,
   if( grpc > 0 )
     memcpy(new_entry->grpv, grpv, grpc * sizeof(uint32_t));
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 /* -- Marker -- */
@@ -1836,7 +3183,7 @@ void VTGen_write_DEF_MARKER(VTGen* gen,
 
   VTGEN_ALLOC_DEF(gen, length);
 
-  new_entry = ((VTBuf_Entry_DefMarker*)gen->buf->pos);
+  new_entry = ((VTBuf_Entry_DefMarker*)gen->defbuf->pos);
 
   new_entry->type   = BUF_ENTRY_TYPE__DefMarker;
   new_entry->length = length;
@@ -1844,20 +3191,53 @@ void VTGen_write_DEF_MARKER(VTGen* gen,
   new_entry->mtype  = mtype;
   strcpy(new_entry->mname, mname);
 
-  VTGEN_JUMP(gen, length);
+  VTGEN_JUMP_DEF(gen, length);
 }
 
 
 /* - Event records - */
 
 
+/* Check whether counter records at the given time still belong to the
+   call of a retractable ENTER record (see VTGen_write_LEAVE), i.e. they
+   directly follow it and were sampled either at its time or at one later
+   time, which is the one of the LEAVE record then */
+static uint8_t VTGen_short_counter(VTGen* gen, uint64_t* time)
+{
+  if (gen->shortend == NULL || gen->buf->pos != gen->shortend)
+    return 0;
+
+  if (*time == gen->shortmark.time)
+    return 1;
+
+  if (!gen->shortcntr)
+  {
+    gen->shortcntr = 1;
+    gen->shortcntrtime = *time;
+    return 1;
+  }
+
+  return (*time == gen->shortcntrtime);
+}
+
 /* -- Region -- */
 
 void VTGen_write_ENTER(VTGen* gen, uint64_t* time, uint32_t rid, uint32_t sid)
 {
   VTGEN_CHECK(gen);
 
-  if (VTGEN_IS_TRACE_ON(gen))
+  if (VTGEN_IS_TRACE_ON(gen) && gen->ispacked)
+  {
+    VTGEN_RESERVE_EVENT(gen, VTGEN_PACKED_MAX_LENGTH);
+
+    VTGEN_MARK_SHORT(gen, time);
+    gen->buf->pos =
+      VTGen_pack_EnterLeave(gen->buf->pos, &gen->buf->ptime,
+                            VTGEN_PACKED_TAG_ENTER, *time, rid, sid);
+
+    gen->shortend = gen->buf->pos;
+  }
+  else if (VTGEN_IS_TRACE_ON(gen))
   {
     VTBuf_Entry_EnterLeave* new_entry;
 
@@ -1866,6 +3246,7 @@ void VTGen_write_ENTER(VTGen* gen, uint64_t* time, uint32_t rid, uint32_t sid)
 
     VTGEN_ALLOC_EVENT(gen, length);
 
+    VTGEN_MARK_SHORT(gen, time);
     new_entry = ((VTBuf_Entry_EnterLeave*)gen->buf->pos);
 
     new_entry->type   = BUF_ENTRY_TYPE__Enter;
@@ -1875,17 +3256,39 @@ void VTGen_write_ENTER(VTGen* gen, uint64_t* time, uint32_t rid, uint32_t sid)
     new_entry->sid    = sid;
 
     VTGEN_JUMP(gen, length);
+
+    gen->shortend = gen->buf->pos;
   }
 
-  if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_FUNC))
-    VTSum_enter(gen->sum, time, rid);
+  if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_FUNC | VT_SUM_PROP_CALLPATH))
+    VTSum_enter(VTGEN_SUM(gen), time, rid);
 }
 
 void VTGen_write_LEAVE(VTGen* gen, uint64_t* time, uint32_t rid, uint32_t sid)
 {
   VTGEN_CHECK(gen);
 
-  if (VTGEN_IS_TRACE_ON(gen))
+  /* retract ENTER record of a call shorter than VT_MIN_DURATION, if no
+     other record than the counter records of the call was written in
+     between */
+  if (gen->buf->pos == gen->shortend && gen->shortend != NULL &&
+      gen->minduration > 0 &&
+      *time - gen->shortmark.time < gen->minduration &&
+      (!gen->shortcntr || gen->shortcntrtime == *time))
+  {
+    gen->buf->pos   = gen->shortmark.pos;
+    gen->buf->ptime = gen->shortmark.ptime;
+    gen->shortend   = NULL;
+  }
+  else if (VTGEN_IS_TRACE_ON(gen) && gen->ispacked)
+  {
+    VTGEN_RESERVE_EVENT(gen, VTGEN_PACKED_MAX_LENGTH);
+
+    gen->buf->pos =
+      VTGen_pack_EnterLeave(gen->buf->pos, &gen->buf->ptime,
+                            VTGEN_PACKED_TAG_LEAVE, *time, rid, sid);
+  }
+  else if (VTGEN_IS_TRACE_ON(gen))
   {
     VTBuf_Entry_EnterLeave* new_entry;
 
@@ -1905,8 +3308,8 @@ void VTGen_write_LEAVE(VTGen* gen, uint64_t* time, uint32_t rid, uint32_t sid)
     VTGEN_JUMP(gen, length);
   }
 
-  if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_FUNC))
-    VTSum_exit(gen->sum, time, rid);
+  if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_FUNC | VT_SUM_PROP_CALLPATH))
+    VTSum_exit(VTGEN_SUM(gen), time, rid);
 }
 
 /* -- File I/O -- */
@@ -1949,27 +3352,27 @@ void VTGen_write_FILE_OPERATION(VTGen* gen, uint64_t* time,
     {
       case OTF_FILEOP_OPEN:
       {
-        VTSum_fileop_open(gen->sum, time, fid);
+        VTSum_fileop_open(VTGEN_SUM(gen), time, fid);
         break;
       }
       case OTF_FILEOP_CLOSE:
       {
-        VTSum_fileop_close(gen->sum, time, fid);
+        VTSum_fileop_close(VTGEN_SUM(gen), time, fid);
         break;
       }
       case OTF_FILEOP_READ:
       {
-        VTSum_fileop_read(gen->sum, time, fid, bytes);
+        VTSum_fileop_read(VTGEN_SUM(gen), time, fid, bytes);
         break;
       }
       case OTF_FILEOP_WRITE:
       {
-        VTSum_fileop_write(gen->sum, time, fid, bytes);
+        VTSum_fileop_write(VTGEN_SUM(gen), time, fid, bytes);
         break;
       }
       case OTF_FILEOP_SEEK:
       {
-        VTSum_fileop_seek(gen->sum, time, fid);
+        VTSum_fileop_seek(VTGEN_SUM(gen), time, fid);
         break;
       }
     }
@@ -2040,27 +3443,27 @@ void VTGen_write_END_FILE_OPERATION(VTGen* gen, uint64_t* time,
     {
       case OTF_FILEOP_OPEN:
       {
-        VTSum_fileop_open(gen->sum, time, fid);
+        VTSum_fileop_open(VTGEN_SUM(gen), time, fid);
         break;
       }
       case OTF_FILEOP_CLOSE:
       {
-        VTSum_fileop_close(gen->sum, time, fid);
+        VTSum_fileop_close(VTGEN_SUM(gen), time, fid);
         break;
       }
       case OTF_FILEOP_READ:
       {
-        VTSum_fileop_read(gen->sum, time, fid, bytes);
+        VTSum_fileop_read(VTGEN_SUM(gen), time, fid, bytes);
         break;
       }
       case OTF_FILEOP_WRITE:
       {
-        VTSum_fileop_write(gen->sum, time, fid, bytes);
+        VTSum_fileop_write(VTGEN_SUM(gen), time, fid, bytes);
         break;
       }
       case OTF_FILEOP_SEEK:
       {
-        VTSum_fileop_seek(gen->sum, time, fid);
+        VTSum_fileop_seek(VTGEN_SUM(gen), time, fid);
         break;
       }
     }
@@ -2078,6 +3481,7 @@ void VTGen_write_COUNTER(VTGen* gen, uint64_t* time, uint32_t cid,
   if (VTGEN_IS_TRACE_ON(gen))
   {
     VTBuf_Entry_Counter* new_entry;
+    uint8_t is_short = VTGen_short_counter(gen, time);
 
     uint32_t length =
       VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_Counter));
@@ -2093,6 +3497,52 @@ void VTGen_write_COUNTER(VTGen* gen, uint64_t* time, uint32_t cid,
     new_entry->cval   = cval;
 
     VTGEN_JUMP(gen, length);
+
+    /* the record is retracted together with its call's ENTER record */
+    if (is_short && gen->shortend != NULL)
+      gen->shortend = gen->buf->pos;
+  }
+}
+
+void VTGen_write_COUNTERS(VTGen* gen, uint64_t* time, uint32_t num,
+       const uint32_t* cidv, const uint64_t* cvalv)
+{
+  VTGEN_CHECK(gen);
+
+  if (num == 0) return;
+
+  /* a single counter record is smaller */
+  if (num == 1)
+  {
+    VTGen_write_COUNTER(gen, time, *cidv, *cvalv);
+    return;
+  }
+
+  if (VTGEN_IS_TRACE_ON(gen))
+  {
+    VTBuf_Entry_Counters* new_entry;
+    uint8_t is_short = VTGen_short_counter(gen, time);
+
+    uint32_t length =
+      VTGEN_ALIGN_LENGTH((offsetof(VTBuf_Entry_Counters, cvalv) +
+                          (num * (sizeof(uint64_t) + sizeof(uint32_t)))));
+
+    VTGEN_ALLOC_EVENT(gen, length);
+
+    new_entry = ((VTBuf_Entry_Counters*)gen->buf->pos);
+
+    new_entry->type   = BUF_ENTRY_TYPE__Counters;
+    new_entry->length = length;
+    new_entry->time   = *time;
+    new_entry->num    = num;
+    memcpy(new_entry->cvalv, cvalv, num * sizeof(uint64_t));
+    memcpy(VTGEN_COUNTERS_CIDV(new_entry), cidv, num * sizeof(uint32_t));
+
+    VTGEN_JUMP(gen, length);
+
+    /* the record is retracted together with its call's ENTER record */
+    if (is_short && gen->shortend != NULL)
+      gen->shortend = gen->buf->pos;
   }
 }
 
@@ -2184,7 +3634,7 @@ void VTGen_write_SEND_MSG(VTGen* gen, uint64_t* time, uint32_t pid,
   }
 
   if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_MSG))
-    VTSum_msg_send(gen->sum, time, pid, cid, tag, (uint64_t)sent);
+    VTSum_msg_send(VTGEN_SUM(gen), time, pid, cid, tag, (uint64_t)sent);
 }
 
 void VTGen_write_RECV_MSG(VTGen* gen, uint64_t* time, uint32_t pid,
@@ -2216,7 +3666,7 @@ void VTGen_write_RECV_MSG(VTGen* gen, uint64_t* time, uint32_t pid,
   }
 
   if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_MSG))
-    VTSum_msg_recv(gen->sum, time, pid, cid, tag, (uint64_t)recvd);
+    VTSum_msg_recv(VTGEN_SUM(gen), time, pid, cid, tag, (uint64_t)recvd);
 }
 
 void VTGen_write_COLLECTIVE_OPERATION(VTGen* gen, uint64_t* time,
@@ -2253,7 +3703,7 @@ void VTGen_write_COLLECTIVE_OPERATION(VTGen* gen, uint64_t* time,
   }
 
   if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_COLLOP) && (sent > 0 || recvd > 0))
-    VTSum_collop(gen->sum, time, rid, cid, (uint64_t)sent, (uint64_t)recvd);
+    VTSum_collop(VTGEN_SUM(gen), time, rid, cid, (uint64_t)sent, (uint64_t)recvd);
 }
 
 void VTGen_write_BEGIN_COLLECTIVE_OPERATION(VTGen* gen, uint64_t* time,
@@ -2290,7 +3740,7 @@ void VTGen_write_BEGIN_COLLECTIVE_OPERATION(VTGen* gen, uint64_t* time,
   }
 
   if (VTGEN_IS_SUM_PROP_ON(gen, VT_SUM_PROP_COLLOP) && (sent > 0 || recvd > 0))
-    VTSum_collop(gen->sum, time, rid, cid, sent, recvd);
+    VTSum_collop(VTGEN_SUM(gen), time, rid, cid, sent, recvd);
 }
 
 void VTGen_write_END_COLLECTIVE_OPERATION(VTGen* gen, uint64_t* time,
@@ -2445,14 +3895,23 @@ void VTGen_write_ENTER_FLUSH(VTGen* gen, uint64_t* time)
   VTGEN_CHECK(gen);
 
   if (VTGEN_IS_TRACE_ON(gen))
+    VTGEN_RESERVE_FLUSH(gen, gen->ispacked ? VTGEN_PACKED_MAX_LENGTH :
+                        VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)));
+
+  if (VTGEN_IS_TRACE_ON(gen) && gen->ispacked)
+  {
+    gen->buf->pos =
+      VTGen_pack_EnterLeave(gen->buf->pos, &gen->buf->ptime,
+                            VTGEN_PACKED_TAG_ENTER, *time,
+                            vt_trc_regid[VT__TRC_FLUSH], 0);
+  }
+  else if (VTGEN_IS_TRACE_ON(gen))
   {
     VTBuf_Entry_EnterLeave* new_entry;
 
     uint32_t length =
       VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)); 
 
-    /* NB: No VTGEN_ALLOC_EVENT since space reserved at buffer creation */
-
     new_entry = ((VTBuf_Entry_EnterLeave*)gen->buf->pos);
 
     new_entry->type   = BUF_ENTRY_TYPE__Enter;
@@ -2470,14 +3929,22 @@ void VTGen_write_LEAVE_FLUSH(VTGen* gen, uint64_t* time)
   VTGEN_CHECK(gen);
 
   if (VTGEN_IS_TRACE_ON(gen))
+    VTGEN_RESERVE_FLUSH(gen, gen->ispacked ? VTGEN_PACKED_MAX_LENGTH :
+                        VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave)));
+
+  if (VTGEN_IS_TRACE_ON(gen) && gen->ispacked)
+  {
+    gen->buf->pos =
+      VTGen_pack_EnterLeave(gen->buf->pos, &gen->buf->ptime,
+                            VTGEN_PACKED_TAG_LEAVE, *time, 0, 0);
+  }
+  else if (VTGEN_IS_TRACE_ON(gen))
   {
     VTBuf_Entry_EnterLeave* new_entry;
 
     uint32_t length =
       VTGEN_ALIGN_LENGTH(sizeof(VTBuf_Entry_EnterLeave));
 
-    /* NB: No VTGEN_ALLOC_EVENT since space reserved at buffer creation */
-
     new_entry = ((VTBuf_Entry_EnterLeave*)gen->buf->pos);
 
     new_entry->type   = BUF_ENTRY_TYPE__Leave;
@@ -2622,55 +4089,23 @@ void VTGen_set_rewind_mark(VTGen* gen, uint64_t *time)
 {
   VTGEN_CHECK(gen);
 
-  gen->rewindmark.pos  = gen->buf->pos;
-  gen->rewindmark.time = *time;
+  gen->shortend = NULL;
+
+  gen->rewindmark.pos   = gen->buf->pos;
+  gen->rewindmark.time  = *time;
+  gen->rewindmark.ptime = gen->buf->ptime;
 }
 
 void VTGen_rewind(VTGen* gen, uint64_t *time)
 {
-  buffer_t p;
-  uint32_t length;
-
   VTGEN_CHECK(gen);
 
-  p = gen->rewindmark.pos;
-
-  /* run over trace buffer and shift definition records to
-     the rewind mark, other records will be dropped */
-  while(p < gen->buf->pos)
-  {
-    length = ((VTBuf_Entry_Base*)p)->length;
-
-    switch(((VTBuf_Entry_Base*)p)->type)
-    {
-      case BUF_ENTRY_TYPE__DefinitionComment:
-      case BUF_ENTRY_TYPE__DefSclFile:
-      case BUF_ENTRY_TYPE__DefScl:
-      case BUF_ENTRY_TYPE__DefFileGroup:
-      case BUF_ENTRY_TYPE__DefFile:
-      case BUF_ENTRY_TYPE__DefFunctionGroup:
-      case BUF_ENTRY_TYPE__DefFunction:
-      case BUF_ENTRY_TYPE__DefCollectiveOperation:
-      case BUF_ENTRY_TYPE__DefCounterGroup:
-      case BUF_ENTRY_TYPE__DefCounter:
-      case BUF_ENTRY_TYPE__DefProcessGroup:
-      case BUF_ENTRY_TYPE__DefMarker:
-      {
-        if(p != gen->rewindmark.pos)
-          memmove(gen->rewindmark.pos, p, length);
-        /* move rewind mark behind definition record */
-        gen->rewindmark.pos += length;
-        break;
-      }
-      default:
-        break;
-    }
-
-    p += length;
-  }
+  gen->shortend = NULL;
 
-  /* reset current buffer position */
+  /* drop records behind the rewind mark; definition records are kept in
+     the definition buffer */
   gen->buf->pos = gen->rewindmark.pos;
+  gen->buf->ptime = gen->rewindmark.ptime;
   *time = gen->rewindmark.time;
 }
 
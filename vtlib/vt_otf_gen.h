@@ -53,6 +53,8 @@ EXTERN void VTGen_destroy(VTGen* gen);
 
 EXTERN uint8_t VTGen_get_buflevel(VTGen* gen);
 
+EXTERN void VTGen_request_dump(void);
+
 
 /* -- Writing trace records -- */
 
@@ -132,6 +134,11 @@ EXTERN void VTGen_write_END_FILE_OPERATION(VTGen* gen, uint64_t* time,
 EXTERN void VTGen_write_COUNTER(VTGen* gen, uint64_t* time, uint32_t cid,
                                 uint64_t cval);
 
+/* write the values of `num' counters sampled at the same time as a single
+   buffer record (it's written as `num' counter records to the trace) */
+EXTERN void VTGen_write_COUNTERS(VTGen* gen, uint64_t* time, uint32_t num,
+                                 const uint32_t* cidv, const uint64_t* cvalv);
+
 /* -- Comment -- */
 
 EXTERN void VTGen_write_COMMENT(VTGen* gen, uint64_t* time,
@@ -21,15 +21,27 @@
 #include "vt_error.h"
 #include "vt_inttypes.h"
 #include "vt_pform.h"
+#include "vt_thrd.h"
 #include "vt_trc.h"
 
-#include "util/hash.h"
+#include "util/htab.h"
 
 #include "otf.h"
 
 #define VTSUM_STACK_BSIZE  100
 #define VTSUM_STAT_BSIZE   500
-#define VTSUM_HASH_MAX    1021
+#define VTSUM_CPATH_BSIZE  500
+
+/* layout of the function duration histograms: durations below
+   VTSUM_HIST_SUB_NUM ticks have a bucket of their own, each further power
+   of two is divided into VTSUM_HIST_SUB_NUM buckets of equal width (i.e.
+   the relative error is at most 1/VTSUM_HIST_SUB_NUM); durations of
+   2^VTSUM_HIST_MAX_BITS ticks or more fall into the last bucket */
+#define VTSUM_HIST_SUB_BITS 3
+#define VTSUM_HIST_SUB_NUM  (1 << VTSUM_HIST_SUB_BITS)
+#define VTSUM_HIST_MAX_BITS 48
+#define VTSUM_HIST_NUM \
+  ((VTSUM_HIST_MAX_BITS - VTSUM_HIST_SUB_BITS + 1) * VTSUM_HIST_SUB_NUM)
 
 /*
  *-----------------------------------------------------------------------------
@@ -48,10 +60,30 @@
 		        (_sum->func_stat_size                         \
 		         + VTSUM_STAT_BSIZE)                          \
 		        * sizeof(VTSum_funcStat));                    \
+    if (_sum->func_stat == NULL)                                      \
+      vt_error();                                                     \
+    _sum->func_dirty = (uint64_t*)realloc(_sum->func_dirty,           \
+		        (_sum->func_stat_size                         \
+		         + VTSUM_STAT_BSIZE)                          \
+		        * sizeof(uint64_t));                          \
+    if (_sum->func_dirty == NULL)                                     \
+      vt_error();                                                     \
+    if (_sum->func_hist != NULL)                                      \
+    {                                                                 \
+      _sum->func_hist = (VTSum_funcHist**)realloc(_sum->func_hist,    \
+		          (_sum->func_stat_size                       \
+		           + VTSUM_STAT_BSIZE)                        \
+		          * sizeof(VTSum_funcHist*));                 \
+      if (_sum->func_hist == NULL)                                    \
+        vt_error();                                                   \
+    }                                                                 \
     _sum->func_stat_size += VTSUM_STAT_BSIZE;                         \
   }                                                                   \
                                                                       \
   _stat_idx = _sum->func_stat_num++;                                  \
+  _sum->func_stat[_stat_idx].dirty = 0;                               \
+  if (_sum->func_hist != NULL)                                        \
+    _sum->func_hist[_stat_idx] = NULL;                                \
                                                                       \
   _sum->func_stat[_stat_idx].rid  = _rid;                             \
   _sum->func_stat[_stat_idx].cnt  = 0;                                \
@@ -67,10 +99,19 @@
 		       (_sum->msg_stat_size                           \
 		        + VTSUM_STAT_BSIZE)                           \
 		       * sizeof(VTSum_msgStat));                      \
+    if (_sum->msg_stat == NULL)                                       \
+      vt_error();                                                     \
+    _sum->msg_dirty = (uint64_t*)realloc(_sum->msg_dirty,             \
+		        (_sum->msg_stat_size                          \
+		         + VTSUM_STAT_BSIZE)                          \
+		        * sizeof(uint64_t));                          \
+    if (_sum->msg_dirty == NULL)                                      \
+      vt_error();                                                     \
     _sum->msg_stat_size += VTSUM_STAT_BSIZE;                          \
   }                                                                   \
                                                                       \
   _stat_idx = _sum->msg_stat_num++;                                   \
+  _sum->msg_stat[_stat_idx].dirty = 0;                                \
                                                                       \
   _sum->msg_stat[_stat_idx].peer  = _peer;                            \
   _sum->msg_stat[_stat_idx].cid   = _cid;                             \
@@ -89,10 +130,19 @@
 			  (_sum->collop_stat_size                     \
 			   + VTSUM_STAT_BSIZE)                        \
 			  * sizeof(VTSum_collopStat));                \
+    if (_sum->collop_stat == NULL)                                    \
+      vt_error();                                                     \
+    _sum->collop_dirty = (uint64_t*)realloc(_sum->collop_dirty,       \
+		        (_sum->collop_stat_size                       \
+		         + VTSUM_STAT_BSIZE)                          \
+		        * sizeof(uint64_t));                          \
+    if (_sum->collop_dirty == NULL)                                   \
+      vt_error();                                                     \
     _sum->collop_stat_size += VTSUM_STAT_BSIZE;                       \
   }						                      \
                                                                       \
   _stat_idx = _sum->collop_stat_num++;                                \
+  _sum->collop_stat[_stat_idx].dirty = 0;                             \
                                                                       \
   _sum->collop_stat[_stat_idx].rid   = _rid;                          \
   _sum->collop_stat[_stat_idx].cid   = _cid;                          \
@@ -110,10 +160,19 @@
 			  (_sum->fileop_stat_size                     \
 			   + VTSUM_STAT_BSIZE)                        \
 			  * sizeof(VTSum_fileopStat));                \
+    if (_sum->fileop_stat == NULL)                                    \
+      vt_error();                                                     \
+    _sum->fileop_dirty = (uint64_t*)realloc(_sum->fileop_dirty,       \
+		        (_sum->fileop_stat_size                       \
+		         + VTSUM_STAT_BSIZE)                          \
+		        * sizeof(uint64_t));                          \
+    if (_sum->fileop_dirty == NULL)                                   \
+      vt_error();                                                     \
     _sum->fileop_stat_size += VTSUM_STAT_BSIZE;                       \
   }                                                                   \
                                                                       \
   _stat_idx = _sum->fileop_stat_num++;                                \
+  _sum->fileop_stat[_stat_idx].dirty = 0;                             \
                                                                       \
   _sum->fileop_stat[_stat_idx].fid    = _fid;                         \
   _sum->fileop_stat[_stat_idx].nopen  = 0;                            \
@@ -125,6 +184,17 @@
   _sum->fileop_stat[_stat_idx].wrote  = 0;                            \
 }
 
+/* mark statistic `_stat_idx' of kind `_kind' (func, msg, collop, fileop) as
+   changed since the last dump */
+#define VTSUM_MARK_DIRTY(_sum, _kind, _stat_idx)                      \
+  do {                                                                \
+    if (!_sum->_kind##_stat[_stat_idx].dirty)                         \
+    {                                                                 \
+      _sum->_kind##_stat[_stat_idx].dirty = 1;                        \
+      _sum->_kind##_dirty[_sum->_kind##_dirty_num++] = _stat_idx;     \
+    }                                                                 \
+  } while(0)
+
 #define VTSUM_STACK_PUSH(_sum, _stat_idx, _time)                      \
 {                                                                     \
   if (_sum->stack_pos+1 == (int32_t)_sum->stack_size)                 \
@@ -137,6 +207,7 @@
   }                                                                   \
                                                                       \
   _sum->func_stat[_stat_idx].cnt++;                                   \
+  VTSUM_MARK_DIRTY(_sum, func, _stat_idx);                            \
                                                                       \
   _sum->stack_pos++;                                                  \
   _sum->stack[_sum->stack_pos].stat_idx = _stat_idx;                  \
@@ -147,6 +218,8 @@
   {                                                                   \
     _sum->func_stat[_sum->stack[_sum->stack_pos-1].stat_idx].excl +=  \
        (*_time - _sum->stack[_sum->stack_pos-1].hexcl);               \
+    VTSUM_MARK_DIRTY(_sum, func,                                      \
+                     _sum->stack[_sum->stack_pos-1].stat_idx);        \
   }                                                                   \
 }
 
@@ -159,12 +232,42 @@
      (*_time - _sum->stack[_sum->stack_pos].hexcl);                   \
   _sum->func_stat[_sum->stack[_sum->stack_pos].stat_idx].incl +=      \
      (*_time - _sum->stack[_sum->stack_pos].hincl);                   \
+  VTSUM_MARK_DIRTY(_sum, func, _sum->stack[_sum->stack_pos].stat_idx);\
+  if (_sum->func_hist != NULL)                                        \
+    hist_add(_sum, _sum->stack[_sum->stack_pos].stat_idx,             \
+	     *_time - _sum->stack[_sum->stack_pos].hincl);            \
                                                                       \
   _sum->stack_pos--;                                                  \
   if (_sum->stack_pos != -1)                                          \
      _sum->stack[_sum->stack_pos].hexcl = *_time;                     \
 }
 
+#define VTSUM_CPATH_NODE_ADD(_sum, _parent, _rid, _node)             \
+{                                                                     \
+  if (_sum->cpath_node_num == _sum->cpath_node_size)                  \
+  {                                                                   \
+    _sum->cpath_node = (VTSum_cpathNode*)realloc(_sum->cpath_node,    \
+			 (_sum->cpath_node_size                       \
+			  + VTSUM_CPATH_BSIZE)                        \
+			 * sizeof(VTSum_cpathNode));                  \
+    if (_sum->cpath_node == NULL)                                     \
+      vt_error();                                                     \
+    _sum->cpath_node_size += VTSUM_CPATH_BSIZE;                       \
+  }                                                                   \
+                                                                      \
+  _node = _sum->cpath_node_num++;                                     \
+                                                                      \
+  _sum->cpath_node[_node].rid     = _rid;                             \
+  _sum->cpath_node[_node].parent  = _parent;                          \
+  _sum->cpath_node[_node].child   = 0;                                \
+  _sum->cpath_node[_node].sibling = _sum->cpath_node[_parent].child;  \
+  _sum->cpath_node[_node].depth   = _sum->cpath_node[_parent].depth+1;\
+  _sum->cpath_node[_node].cnt     = 0;                                \
+  _sum->cpath_node[_node].excl    = 0;                                \
+  _sum->cpath_node[_node].incl    = 0;                                \
+  _sum->cpath_node[_parent].child = _node;                            \
+}
+
 #define VT_CHECK_DUMP(_sum, _time)                                    \
   if (*_time >= _sum->next_dump) VTSum_dump(_sum, 1);
 
@@ -189,6 +292,7 @@ typedef struct
   uint64_t         cnt;
   uint64_t         excl;
   uint64_t         incl;
+  uint8_t          dirty;  /* changed since the last dump? */
 } VTSum_funcStat;
 
 /* Data structure for message statistic */
@@ -202,6 +306,7 @@ typedef struct
   uint64_t         rcnt;
   uint64_t         sent;
   uint64_t         recvd;
+  uint8_t          dirty;  /* changed since the last dump? */
 } VTSum_msgStat;
 
 /* Data structure for collective operation statistics */
@@ -214,6 +319,7 @@ typedef struct
   uint64_t         rcnt;
   uint64_t         sent; 
   uint64_t         recvd;
+  uint8_t          dirty;  /* changed since the last dump? */
 } VTSum_collopStat;
 
 /* Data structure for file operation statistic */
@@ -228,6 +334,7 @@ typedef struct
   uint64_t         nseek;
   uint64_t         read;
   uint64_t         wrote;
+  uint8_t          dirty;  /* changed since the last dump? */
 } VTSum_fileopStat;
 
 /* Data structure for call stack */
@@ -239,22 +346,49 @@ typedef struct
   uint64_t         stat_idx;
 } VTSum_stack;
 
+/* Data structure for node of the calling-context tree; the nodes are kept
+   in a pool and refer to each other by index, node 0 is the (virtual) root */
+
+typedef struct
+{
+  uint32_t         rid;
+  uint32_t         parent;   /* index of parent node                 */
+  uint32_t         child;    /* index of first child node (0 = none) */
+  uint32_t         sibling;  /* index of next sibling node (0 = none) */
+  uint32_t         depth;
+  uint64_t         cnt;
+  uint64_t         excl;
+  uint64_t         incl;
+} VTSum_cpathNode;
+
+/* Data structure for histogram of the (inclusive) durations of a function;
+   counts saturate at 2^32-1 */
+
+typedef struct
+{
+  uint64_t         max;      /* maximum duration */
+  uint32_t         cnt[VTSUM_HIST_NUM];
+} VTSum_funcHist;
+
 /* Hash table to map function ids to statistic */
 
 typedef struct HN_func
 {
   uint32_t id;              /* hash code (identifier of region) */
   uint64_t stat_idx;        /* index of associated statistic    */
-  struct HN_func* next;
 } VTSum_funcHashNode;
 
 /* Hash table to map message peer, comm, and tag to statistic */
 
+typedef struct HN_msg_key
+{
+  uint32_t peer, cid, tag;  /* peer, comm, tag of message    */
+} VTSum_msgHashKey;
+
 typedef struct HN_msg
 {
   uint32_t peer, cid, tag;  /* peer, comm, tag of message    */
   uint64_t stat_idx;        /* index of associated statistic */
-  struct HN_msg* next;
 } VTSum_msgHashNode;
 
 /* Hash table to map collop and comm to statistic */
@@ -263,7 +397,6 @@ typedef struct HN_collop
 {
   uint32_t rid, cid;        /* op, comm of collective op.    */
   uint64_t stat_idx;        /* index of associated statistic */
-  struct HN_collop* next;
 } VTSum_collopHashNode;
 
 /* Hash table to map file op. ids to statistic */
@@ -272,7 +405,6 @@ typedef struct HN_fileop
 {
   uint32_t id;              /* hash code (identifier of file op.) */
   uint64_t stat_idx;        /* index of associated statistic      */
-  struct HN_fileop* next;
 } VTSum_fileopHashNode;
 
 /* VTSum record */
@@ -282,29 +414,50 @@ struct VTSum_struct
   VTGen*                 gen;
 
   VTSum_funcStat*        func_stat;
-  VTSum_funcHashNode**   func_stat_htab;
+  VTHtab*                func_stat_htab;
   VTSum_stack*           stack;
   uint64_t               func_stat_size;
   uint64_t               func_stat_num;
+  uint64_t*              func_dirty;
+  uint64_t               func_dirty_num;
+  VTSum_funcHist**       func_hist;  /* histograms (NULL, if disabled) */
   uint32_t               stack_size;
   int32_t                stack_pos;
 
   VTSum_msgStat*         msg_stat;
-  VTSum_msgHashNode**    msg_stat_htab;
+  VTHtab*                msg_stat_htab;
   uint64_t               msg_stat_size;
   uint64_t               msg_stat_num;
+  uint64_t*              msg_dirty;
+  uint64_t               msg_dirty_num;
   uint8_t                msg_stat_dtls;
 
   VTSum_collopStat*      collop_stat;
-  VTSum_collopHashNode** collop_stat_htab;
+  VTHtab*                collop_stat_htab;
   uint64_t               collop_stat_size;
   uint64_t               collop_stat_num;
+  uint64_t*              collop_dirty;
+  uint64_t               collop_dirty_num;
   uint8_t                collop_stat_dtls;
 
   VTSum_fileopStat*      fileop_stat;
-  VTSum_fileopHashNode** fileop_stat_htab;
+  VTHtab*                fileop_stat_htab;
   uint64_t               fileop_stat_size;
   uint64_t               fileop_stat_num;
+  uint64_t*              fileop_dirty;
+  uint64_t               fileop_dirty_num;
+
+  VTSum_cpathNode*       cpath_node;
+  VTHtab*                cpath_htab;
+  VTSum_stack*           cpath_stack;
+  uint32_t               cpath_node_size;
+  uint32_t               cpath_node_num;
+  uint32_t               cpath_stack_size;
+  int32_t                cpath_stack_pos;
+  uint32_t               cpath_max_depth;
+  uint32_t               cpath_max_nodes;
+  uint32_t               cpath_skip;
+  uint64_t               cpath_skipped;
 
   uint32_t               tid;
   uint64_t               intv;
@@ -318,49 +471,23 @@ static uint64_t SumIntv = 0;
 /* Stores index of function statistic `stat_idx' under hash code `h' */
 
 static void hash_put_func(VTSum* sum, uint32_t h, uint64_t stat_idx) {
-  uint32_t id = h % VTSUM_HASH_MAX;
   VTSum_funcHashNode* add =
-    (VTSum_funcHashNode*)malloc(sizeof(VTSum_funcHashNode));
+    (VTSum_funcHashNode*)vt_htab_put_int(sum->func_stat_htab, h, NULL);
   add->id = h;
   add->stat_idx = stat_idx;
-  add->next = sum->func_stat_htab[id];
-  sum->func_stat_htab[id] = add;
 }
 
 /* Lookup hash code `h'
  * Returns hash table entry if already stored, otherwise NULL */
 
 static VTSum_funcHashNode* hash_get_func(VTSum* sum, uint32_t h) {
-  uint32_t id = h % VTSUM_HASH_MAX;
-  VTSum_funcHashNode* curr = sum->func_stat_htab[id];
-  while ( curr ) {
-    if ( curr->id == h ) {
-      return curr;
-    }
-    curr = curr->next;
-  }
-  return NULL;
+  return (VTSum_funcHashNode*)vt_htab_get_int(sum->func_stat_htab, h);
 }
 
 /* Clear hash table for function statistics */
 
 static void hash_clear_func(VTSum* sum) {
-  int i;
-  VTSum_funcHashNode* tmp;
-
-  if (!sum->func_stat_htab) return;
-
-  for (i = 0; i < VTSUM_HASH_MAX; i++)
-  {
-    while( sum->func_stat_htab[i] )
-    {
-      tmp = sum->func_stat_htab[i]->next;
-      free(sum->func_stat_htab[i]);
-      sum->func_stat_htab[i] = tmp;
-    }
-  }
-
-  free(sum->func_stat_htab);
+  vt_htab_free(sum->func_stat_htab);
 }
 
 /* Stores index of message statistic `stat_idx' under hash code
@@ -369,22 +496,18 @@ static void hash_clear_func(VTSum* sum) {
 static void hash_put_msg(VTSum* sum, uint32_t peer, uint32_t cid, uint32_t tag,
 			 uint64_t stat_idx)
 {
-  uint32_t id;
+  VTSum_msgHashKey key;
   VTSum_msgHashNode* add;
 
-  id = 0;
-  if ( peer > 0 ) id = vt_hash((uint8_t*)&peer, sizeof(uint32_t), id);
-  if ( cid > 0 )  id = vt_hash((uint8_t*)&cid,  sizeof(uint32_t), id);
-  if ( tag > 0 )  id = vt_hash((uint8_t*)&tag,  sizeof(uint32_t), id);
-  id %= VTSUM_HASH_MAX;
+  key.peer = peer;
+  key.cid  = cid;
+  key.tag  = tag;
 
-  add = (VTSum_msgHashNode*)malloc(sizeof(VTSum_msgHashNode));
+  add = (VTSum_msgHashNode*)vt_htab_put(sum->msg_stat_htab, &key, NULL);
   add->peer     = peer;
   add->cid      = cid;
   add->tag      = tag;
   add->stat_idx = stat_idx;
-  add->next     = sum->msg_stat_htab[id];
-  sum->msg_stat_htab[id] = add;
 }
 
 /* Lookup hash code input `peer',`cid',`tag'
@@ -392,46 +515,19 @@ static void hash_put_msg(VTSum* sum, uint32_t peer, uint32_t cid, uint32_t tag,
 
 static VTSum_msgHashNode* hash_get_msg(VTSum* sum, uint32_t peer, uint32_t cid,
 				       uint32_t tag) {
-  uint32_t id;
-  VTSum_msgHashNode* curr;
-
-  id = 0;
-  if ( peer > 0 ) id = vt_hash((uint8_t*)&peer, sizeof(uint32_t), id);
-  if ( cid > 0 )  id = vt_hash((uint8_t*)&cid,  sizeof(uint32_t), id);
-  if ( tag > 0 )  id = vt_hash((uint8_t*)&tag,  sizeof(uint32_t), id);
-  id %= VTSUM_HASH_MAX;
-
-  curr = sum->msg_stat_htab[id];
-  while ( curr ) {
-    if ( curr->peer == peer &&
-	 curr->cid == cid &&
-	 curr->tag == tag ) {
-       return curr;
-    }
-    curr = curr->next;
-  }
-  return NULL;
+  VTSum_msgHashKey key;
+
+  key.peer = peer;
+  key.cid  = cid;
+  key.tag  = tag;
+
+  return (VTSum_msgHashNode*)vt_htab_get(sum->msg_stat_htab, &key);
 }
 
 /* Clear hash table for message statistics */
 
 static void hash_clear_msg(VTSum* sum) {
-  int i;
-  VTSum_msgHashNode* tmp;
-
-  if (!sum->msg_stat_htab) return;
-
-  for (i = 0; i < VTSUM_HASH_MAX; i++)
-  {
-    while( sum->msg_stat_htab[i] )
-    {
-      tmp = sum->msg_stat_htab[i]->next;
-      free(sum->msg_stat_htab[i]);
-      sum->msg_stat_htab[i] = tmp;
-    }
-  }
-
-  free(sum->msg_stat_htab);
+  vt_htab_free(sum->msg_stat_htab);
 }
 
 /* Stores index of collective operation statistic `stat_idx' under hash code
@@ -439,20 +535,12 @@ static void hash_clear_msg(VTSum* sum) {
 
 static void hash_put_collop(VTSum* sum, uint32_t rid, uint32_t cid,
 			    uint64_t stat_idx) {
-  uint32_t id;
-  VTSum_collopHashNode* add;
-
-  id = 0;
-  if ( rid > 0 ) id = vt_hash((uint8_t*)&rid, sizeof(uint32_t), id);
-  if ( cid > 0 ) id = vt_hash((uint8_t*)&cid, sizeof(uint32_t), id);
-  id %= VTSUM_HASH_MAX;
-
-  add = (VTSum_collopHashNode*)malloc(sizeof(VTSum_collopHashNode));
+  VTSum_collopHashNode* add =
+    (VTSum_collopHashNode*)vt_htab_put_int(sum->collop_stat_htab,
+                                           ((uint64_t)rid << 32) | cid, NULL);
   add->rid        = rid;
   add->cid        = cid;
   add->stat_idx   = stat_idx;
-  add->next       = sum->collop_stat_htab[id];
-  sum->collop_stat_htab[id] = add;
 }
 
 /* Lookup hash code `h'
@@ -460,92 +548,323 @@ static void hash_put_collop(VTSum* sum, uint32_t rid, uint32_t cid,
 
 static VTSum_collopHashNode* hash_get_collop(VTSum* sum, uint32_t rid,
 					     uint32_t cid) {
-  uint32_t id;
-  VTSum_collopHashNode* curr;
-
-  id = 0;
-  if ( rid > 0 ) id = vt_hash((uint8_t*)&rid, sizeof(uint32_t), id);
-  if ( cid > 0 ) id = vt_hash((uint8_t*)&cid, sizeof(uint32_t), id);
-  id %= VTSUM_HASH_MAX;
-
-  curr = sum->collop_stat_htab[id];
-  while ( curr ) {
-    if ( curr->rid == rid &&
-	 curr->cid == cid ) {
-       return curr;
-    }
-    curr = curr->next;
-  }
-  return NULL;
+  return (VTSum_collopHashNode*)vt_htab_get_int(sum->collop_stat_htab,
+                                                ((uint64_t)rid << 32) | cid);
 }
 
 /* Clear hash table for collective operation statistics */
 
 static void hash_clear_collop(VTSum* sum) {
-  int i;
-  VTSum_collopHashNode* tmp;
-
-  if (!sum->collop_stat_htab) return;
-
-  for (i = 0; i < VTSUM_HASH_MAX; i++)
-  {
-    while( sum->collop_stat_htab[i] )
-    {
-      tmp = sum->collop_stat_htab[i]->next;
-      free(sum->collop_stat_htab[i]);
-      sum->collop_stat_htab[i] = tmp;
-    }
-  }
-
-  free(sum->collop_stat_htab);
+  vt_htab_free(sum->collop_stat_htab);
 }
 
 /* Stores index of file operation statistic `stat_idx' under hash code `h' */
 
 static void hash_put_fileop(VTSum* sum, uint32_t h, uint64_t stat_idx) {
-  uint32_t id = h % VTSUM_HASH_MAX;
   VTSum_fileopHashNode* add =
-    (VTSum_fileopHashNode*)malloc(sizeof(VTSum_fileopHashNode));
+    (VTSum_fileopHashNode*)vt_htab_put_int(sum->fileop_stat_htab, h, NULL);
   add->id       = h;
   add->stat_idx = stat_idx;
-  add->next     = sum->fileop_stat_htab[id];
-  sum->fileop_stat_htab[id] = add;
 }
 
 /* Lookup hash code `h'
  * Returns hash table entry if already stored, otherwise NULL */
 
 static VTSum_fileopHashNode* hash_get_fileop(VTSum* sum, uint32_t h) {
-  uint32_t id = h % VTSUM_HASH_MAX;
-  VTSum_fileopHashNode* curr = sum->fileop_stat_htab[id];
-  while ( curr ) {
-    if ( curr->id == h ) {
-      return curr;
-    }
-    curr = curr->next;
-  }
-  return NULL;
+  return (VTSum_fileopHashNode*)vt_htab_get_int(sum->fileop_stat_htab, h);
 }
 
 /* Clear hash table for file operation statistics */
 
 static void hash_clear_fileop(VTSum* sum) {
-  int i;
-  VTSum_fileopHashNode* tmp;
+  vt_htab_free(sum->fileop_stat_htab);
+}
+
+/* Add duration `dur' to the histogram of function statistic `stat_idx';
+   the histogram is allocated at the first call */
+
+static void hist_add(VTSum* sum, uint64_t stat_idx, uint64_t dur)
+{
+  VTSum_funcHist* hist = sum->func_hist[stat_idx];
+  uint32_t b;
+
+  if (hist == NULL)
+  {
+    hist = (VTSum_funcHist*)calloc(1, sizeof(VTSum_funcHist));
+    if (hist == NULL)
+      vt_error();
+    sum->func_hist[stat_idx] = hist;
+  }
+
+  if (dur < VTSUM_HIST_SUB_NUM)
+  {
+    b = (uint32_t)dur;
+  }
+  else
+  {
+    uint64_t v = dur;
+    uint32_t msb = 0;
+
+    /* position of the most significant bit */
+    if (v >> 32) { v >>= 32; msb += 32; }
+    if (v >> 16) { v >>= 16; msb += 16; }
+    if (v >> 8)  { v >>= 8;  msb += 8;  }
+    if (v >> 4)  { v >>= 4;  msb += 4;  }
+    if (v >> 2)  { v >>= 2;  msb += 2;  }
+    if (v >> 1)  { msb += 1; }
+
+    if (msb >= VTSUM_HIST_MAX_BITS)
+      b = VTSUM_HIST_NUM - 1;
+    else
+      b = (msb - VTSUM_HIST_SUB_BITS + 1) * VTSUM_HIST_SUB_NUM
+	  + (uint32_t)((dur >> (msb - VTSUM_HIST_SUB_BITS))
+		       & (VTSUM_HIST_SUB_NUM - 1));
+  }
+
+  if (hist->cnt[b] != (uint32_t)-1)
+    hist->cnt[b]++;
+  if (dur > hist->max)
+    hist->max = dur;
+}
+
+/* Write function duration histograms to the histogram file of the thread;
+   each line holds the region id, the maximum duration, and the non-empty
+   buckets as `bucket:count' */
+
+static void hist_write(VTSum* sum)
+{
+  FILE* hist_file;
+  char  hist_filename[1024];
+  uint32_t pid = 65536 * sum->tid + vt_my_trace + 1;
+  uint64_t i;
+  uint32_t b;
+
+  /* compose histogram file name */
+  if (vt_my_funique > 0)
+    snprintf(hist_filename, sizeof(hist_filename) - 1, "%s/%s_%u.%x.hist",
+	     vt_env_gdir(), vt_env_fprefix(), vt_my_funique, pid);
+  else
+    snprintf(hist_filename, sizeof(hist_filename) - 1, "%s/%s.%x.hist",
+	     vt_env_gdir(), vt_env_fprefix(), pid);
+
+  /* open histogram file */
+  hist_file = fopen(hist_filename, "w");
+  if (hist_file == NULL)
+  {
+    vt_warning("Cannot open file %s", hist_filename);
+    return;
+  }
+
+  fprintf(hist_file, "# VampirTrace function duration histograms of "
+		     "process %d, thread %u\n", vt_my_trace, sum->tid);
+  fprintf(hist_file, "# %u sub-bucket bits, %u buckets, durations in ticks\n",
+	  VTSUM_HIST_SUB_BITS, VTSUM_HIST_NUM);
+  fprintf(hist_file, "# region max bucket:count ...\n");
+
+  for (i = 0; i < sum->func_stat_num; i++)
+  {
+    VTSum_funcHist* hist = sum->func_hist[i];
+
+    if (hist == NULL) continue;
+
+    fprintf(hist_file, "%u %llu", sum->func_stat[i].rid,
+	    (unsigned long long)hist->max);
+    for (b = 0; b < VTSUM_HIST_NUM; b++)
+    {
+      if (hist->cnt[b] > 0)
+	fprintf(hist_file, " %u:%u", b, hist->cnt[b]);
+    }
+    fprintf(hist_file, "\n");
+  }
+
+  /* close histogram file */
+  fclose(hist_file);
+
+  vt_cntl_msg(2, "Wrote function histogram file %s", hist_filename);
+}
+
+/* Enter region `rid' in the calling-context tree; calls beyond the depth
+   cap or the node budget are accounted to the deepest node on the stack */
+
+static void cpath_enter(VTSum* sum, uint64_t* time, uint32_t rid)
+{
+  uint32_t parent;
+  uint32_t node;
+  uint32_t* hn;
+  uint64_t key;
+
+  if (sum->cpath_skip > 0)
+  {
+    sum->cpath_skip++;
+    return;
+  }
+
+  parent = (sum->cpath_stack_pos == -1) ?
+    0 : (uint32_t)sum->cpath_stack[sum->cpath_stack_pos].stat_idx;
 
-  if (!sum->fileop_stat_htab) return;
+  if (sum->cpath_max_depth > 0 &&
+      sum->cpath_node[parent].depth >= sum->cpath_max_depth)
+  {
+    sum->cpath_skip++;
+    sum->cpath_skipped++;
+    return;
+  }
+
+  /* get node of region `rid' called from node `parent' */
+
+  key = ((uint64_t)parent << 32) | rid;
 
-  for (i = 0; i < VTSUM_HASH_MAX; i++)
+  if ( (hn = (uint32_t*)vt_htab_get_int(sum->cpath_htab, key)) )
+  {
+    node = *hn;
+  }
+  else
   {
-    while( sum->fileop_stat_htab[i] )
+    if (sum->cpath_max_nodes > 0 &&
+	sum->cpath_node_num > sum->cpath_max_nodes)
     {
-      tmp = sum->fileop_stat_htab[i]->next;
-      free(sum->fileop_stat_htab[i]);
-      sum->fileop_stat_htab[i] = tmp;
+      sum->cpath_skip++;
+      sum->cpath_skipped++;
+      return;
     }
+
+    VTSUM_CPATH_NODE_ADD(sum, parent, rid, node);
+    *(uint32_t*)vt_htab_put_int(sum->cpath_htab, key, NULL) = node;
+  }
+
+  /* push node to the call stack */
+
+  if (sum->cpath_stack_pos+1 == (int32_t)sum->cpath_stack_size)
+  {
+    sum->cpath_stack = (VTSum_stack*)realloc(sum->cpath_stack,
+			 (sum->cpath_stack_size + VTSUM_STACK_BSIZE)
+			 * sizeof(VTSum_stack));
+    if (sum->cpath_stack == NULL)
+      vt_error();
+    sum->cpath_stack_size += VTSUM_STACK_BSIZE;
   }
 
-  free(sum->fileop_stat_htab);
+  sum->cpath_node[node].cnt++;
+
+  sum->cpath_stack_pos++;
+  sum->cpath_stack[sum->cpath_stack_pos].stat_idx = node;
+  sum->cpath_stack[sum->cpath_stack_pos].hexcl = *time;
+  sum->cpath_stack[sum->cpath_stack_pos].hincl = *time;
+
+  if (sum->cpath_stack_pos > 0)
+  {
+    sum->cpath_node[parent].excl +=
+      (*time - sum->cpath_stack[sum->cpath_stack_pos-1].hexcl);
+  }
+}
+
+/* Leave the current node of the calling-context tree */
+
+static void cpath_exit(VTSum* sum, uint64_t* time)
+{
+  VTSum_stack* top;
+
+  if (sum->cpath_skip > 0)
+  {
+    sum->cpath_skip--;
+    return;
+  }
+
+  if (sum->cpath_stack_pos == -1)
+    vt_error_msg("Abort: Stack underflow");
+
+  top = &(sum->cpath_stack[sum->cpath_stack_pos]);
+
+  sum->cpath_node[top->stat_idx].excl += (*time - top->hexcl);
+  sum->cpath_node[top->stat_idx].incl += (*time - top->hincl);
+
+  sum->cpath_stack_pos--;
+  if (sum->cpath_stack_pos != -1)
+    sum->cpath_stack[sum->cpath_stack_pos].hexcl = *time;
+}
+
+/* Write calling-context tree in depth-first order to the call-path
+   profile file of the thread */
+
+static void cpath_write(VTSum* sum)
+{
+  FILE* cpath_file;
+  char  cpath_filename[1024];
+  uint32_t pid = 65536 * sum->tid + vt_my_trace + 1;
+  double res = (double)vt_pform_clockres();
+  uint32_t node;
+
+  /* compose call-path profile file name */
+  if (vt_my_funique > 0)
+    snprintf(cpath_filename, sizeof(cpath_filename) - 1, "%s/%s_%u.%x.cpath",
+	     vt_env_gdir(), vt_env_fprefix(), vt_my_funique, pid);
+  else
+    snprintf(cpath_filename, sizeof(cpath_filename) - 1, "%s/%s.%x.cpath",
+	     vt_env_gdir(), vt_env_fprefix(), pid);
+
+  /* open call-path profile file */
+  cpath_file = fopen(cpath_filename, "w");
+  if (cpath_file == NULL)
+  {
+    vt_warning("Cannot open file %s", cpath_filename);
+    return;
+  }
+
+  fprintf(cpath_file, "# VampirTrace call-path profile of process %d, "
+		      "thread %u (%u nodes)\n",
+	  vt_my_trace, sum->tid, sum->cpath_node_num - 1);
+  fprintf(cpath_file, "# %12s %14s %14s  %s\n",
+	  "calls", "excl [s]", "incl [s]", "call path");
+
+  /* traverse the tree in pre-order */
+
+  node = sum->cpath_node[0].child;
+  while (node != 0)
+  {
+    VTSum_cpathNode* n = &(sum->cpath_node[node]);
+    const char* rname = NULL;
+
+#if !defined(VT_DISABLE_RFG)
+    RFG_RegionInfo* rinf =
+      RFG_Regions_getIndexed(VTTHRD_RFGREGIONS(VTThrdv[0]), n->rid);
+    if (rinf != NULL)
+      rname = rinf->regionName;
+#endif /* VT_DISABLE_RFG */
+
+    fprintf(cpath_file, "  %12llu %14.6f %14.6f  %*s",
+	    (unsigned long long)n->cnt, (double)n->excl / res,
+	    (double)n->incl / res, (int)(2 * (n->depth - 1)), "");
+    if (rname != NULL)
+      fprintf(cpath_file, "%s\n", rname);
+    else
+      fprintf(cpath_file, "region %u\n", n->rid);
+
+    /* go to first child, next sibling, or next sibling of an ancestor */
+
+    if (n->child != 0)
+    {
+      node = n->child;
+    }
+    else
+    {
+      while (node != 0 && sum->cpath_node[node].sibling == 0)
+	node = sum->cpath_node[node].parent;
+      if (node != 0)
+	node = sum->cpath_node[node].sibling;
+    }
+  }
+
+  if (sum->cpath_skipped > 0)
+  {
+    fprintf(cpath_file, "# %llu calls beyond the depth cap or node budget "
+		        "were accounted to their callers\n",
+	    (unsigned long long)sum->cpath_skipped);
+  }
+
+  /* close call-path profile file */
+  fclose(cpath_file);
+
+  vt_cntl_msg(2, "Wrote call-path profile file %s", cpath_filename);
 }
 
 VTSum* VTSum_open(VTGen* gen, uint32_t tid)
@@ -576,13 +895,28 @@ VTSum* VTSum_open(VTGen* gen, uint32_t tid)
     sum->func_stat_size = VTSUM_STAT_BSIZE;
     sum->func_stat_num = 0;
 
+    /* initialize list of statistics changed since the last dump */
+
+    sum->func_dirty = (uint64_t*)malloc(VTSUM_STAT_BSIZE * sizeof(uint64_t));
+    if (sum->func_dirty == NULL)
+      vt_error();
+    sum->func_dirty_num = 0;
+
     /* initialize hash table for function statistics */
 
     sum->func_stat_htab =
-      (VTSum_funcHashNode**)calloc(VTSUM_HASH_MAX,
-				   sizeof(VTSum_funcHashNode*));
-    if (sum->func_stat_htab == NULL)
-      vt_error();
+      vt_htab_create(VT_HTAB_KEY_INT, 0, sizeof(VTSum_funcHashNode));
+
+    /* initialize duration histograms, if enabled */
+
+    sum->func_hist = NULL;
+    if (vt_env_stat_func_hist())
+    {
+      sum->func_hist = (VTSum_funcHist**)malloc(VTSUM_STAT_BSIZE
+						* sizeof(VTSum_funcHist*));
+      if (sum->func_hist == NULL)
+	vt_error();
+    }
 
     /* initialize call stack */
 
@@ -604,13 +938,18 @@ VTSum* VTSum_open(VTGen* gen, uint32_t tid)
     sum->msg_stat_size = VTSUM_STAT_BSIZE;
     sum->msg_stat_num = 0;
 
+    /* initialize list of statistics changed since the last dump */
+
+    sum->msg_dirty = (uint64_t*)malloc(VTSUM_STAT_BSIZE * sizeof(uint64_t));
+    if (sum->msg_dirty == NULL)
+      vt_error();
+    sum->msg_dirty_num = 0;
+
     /* initialize hash table for message statistics */
     
     sum->msg_stat_htab =
-      (VTSum_msgHashNode**)calloc(VTSUM_HASH_MAX,
-				  sizeof(VTSum_msgHashNode*));
-    if (sum->msg_stat_htab == NULL)
-      vt_error();
+      vt_htab_create(VT_HTAB_KEY_BIN, sizeof(VTSum_msgHashKey),
+		     sizeof(VTSum_msgHashNode));
 
     /* initialize message statistics details */
 
@@ -628,13 +967,17 @@ VTSum* VTSum_open(VTGen* gen, uint32_t tid)
     sum->collop_stat_size = VTSUM_STAT_BSIZE;
     sum->collop_stat_num = 0;
 
+    /* initialize list of statistics changed since the last dump */
+
+    sum->collop_dirty = (uint64_t*)malloc(VTSUM_STAT_BSIZE * sizeof(uint64_t));
+    if (sum->collop_dirty == NULL)
+      vt_error();
+    sum->collop_dirty_num = 0;
+
     /* initialize hash table for collective operation statistics */
     
     sum->collop_stat_htab =
-      (VTSum_collopHashNode**)calloc(VTSUM_HASH_MAX,
-				     sizeof(VTSum_collopHashNode*));
-    if (sum->collop_stat_htab == NULL)
-      vt_error();
+      vt_htab_create(VT_HTAB_KEY_INT, 0, sizeof(VTSum_collopHashNode));
 
     /* initialize collective operation statistics details */
 
@@ -652,13 +995,50 @@ VTSum* VTSum_open(VTGen* gen, uint32_t tid)
     sum->fileop_stat_size = VTSUM_STAT_BSIZE;
     sum->fileop_stat_num = 0;
 
+    /* initialize list of statistics changed since the last dump */
+
+    sum->fileop_dirty = (uint64_t*)malloc(VTSUM_STAT_BSIZE * sizeof(uint64_t));
+    if (sum->fileop_dirty == NULL)
+      vt_error();
+    sum->fileop_dirty_num = 0;
+
     /* initialize hash table for file operation statistics */
 
     sum->fileop_stat_htab =
-      (VTSum_fileopHashNode**)calloc(VTSUM_HASH_MAX,
-				     sizeof(VTSum_fileopHashNode*));
-    if (sum->fileop_stat_htab == NULL)
+      vt_htab_create(VT_HTAB_KEY_INT, 0, sizeof(VTSum_fileopHashNode));
+  }
+
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_CALLPATH))
+  {
+    /* initialize calling-context tree with its root node */
+
+    sum->cpath_node = (VTSum_cpathNode*)calloc(VTSUM_CPATH_BSIZE,
+					       sizeof(VTSum_cpathNode));
+    if (sum->cpath_node == NULL)
       vt_error();
+    sum->cpath_node[0].rid = VT_NO_ID;
+    sum->cpath_node_size = VTSUM_CPATH_BSIZE;
+    sum->cpath_node_num = 1;
+
+    /* initialize hash table for mapping parent node and region id to node */
+
+    sum->cpath_htab = vt_htab_create(VT_HTAB_KEY_INT, 0, sizeof(uint32_t));
+
+    /* initialize call stack of nodes */
+
+    sum->cpath_stack =
+      (VTSum_stack*)malloc(VTSUM_STACK_BSIZE * sizeof(VTSum_stack));
+    if (sum->cpath_stack == NULL)
+      vt_error();
+    sum->cpath_stack_size = VTSUM_STACK_BSIZE;
+    sum->cpath_stack_pos = -1;
+
+    /* initialize depth cap and node budget */
+
+    sum->cpath_max_depth = (uint32_t)vt_env_stat_callpath_depth();
+    sum->cpath_max_nodes = (uint32_t)vt_env_stat_callpath_nodes();
+    sum->cpath_skip = 0;
+    sum->cpath_skipped = 0;
   }
 
   /* set thread id */
@@ -683,8 +1063,13 @@ VTSum* VTSum_open(VTGen* gen, uint32_t tid)
 void VTSum_dump(VTSum* sum, uint8_t markDump)
 {
   uint64_t time = vt_pform_wtime();
-  uint32_t i;
+  uint64_t ovhd_time = VT_OVHD_BEGIN();
+  uint64_t i, n, idx;
 
+  /* interval dumps (markDump) write only the statistics which changed since
+     the last dump; as the records hold the accumulated values, the last
+     record of each statistic is still up to date; the final dump writes
+     all statistics */
 
   /* mark begin of statistics dump */
   if (markDump)
@@ -694,65 +1079,86 @@ void VTSum_dump(VTSum* sum, uint8_t markDump)
 
   if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_FUNC))
   {
-    for(i = 0; i < sum->func_stat_num; i++)
+    n = markDump ? sum->func_dirty_num : sum->func_stat_num;
+    for(i = 0; i < n; i++)
     {
+      idx = markDump ? sum->func_dirty[i] : i;
       VTGen_write_FUNCTION_SUMMARY(sum->gen, &time,
-	sum->func_stat[i].rid,
-	sum->func_stat[i].cnt,
-	sum->func_stat[i].excl,
-	sum->func_stat[i].incl);
+	sum->func_stat[idx].rid,
+	sum->func_stat[idx].cnt,
+	sum->func_stat[idx].excl,
+	sum->func_stat[idx].incl);
+      sum->func_stat[idx].dirty = 0;
     }
+    sum->func_dirty_num = 0;
+
+    /* write duration histograms at the final dump; OTF has no record
+       type for them, so they go to a file of their own */
+    if (!markDump && sum->func_hist != NULL)
+      hist_write(sum);
   }
 
   /* dump message statistics */
 
   if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_MSG))
   {
-    for(i = 0; i < sum->msg_stat_num; i++)
+    n = markDump ? sum->msg_dirty_num : sum->msg_stat_num;
+    for(i = 0; i < n; i++)
     {
+      idx = markDump ? sum->msg_dirty[i] : i;
       VTGen_write_MESSAGE_SUMMARY(sum->gen, &time,
-	sum->msg_stat[i].peer,
-	sum->msg_stat[i].cid,
-	sum->msg_stat[i].tag,
-	sum->msg_stat[i].scnt,
-	sum->msg_stat[i].rcnt,
-	sum->msg_stat[i].sent,
-	sum->msg_stat[i].recvd);
+	sum->msg_stat[idx].peer,
+	sum->msg_stat[idx].cid,
+	sum->msg_stat[idx].tag,
+	sum->msg_stat[idx].scnt,
+	sum->msg_stat[idx].rcnt,
+	sum->msg_stat[idx].sent,
+	sum->msg_stat[idx].recvd);
+      sum->msg_stat[idx].dirty = 0;
     }
+    sum->msg_dirty_num = 0;
   }
 
   /* dump collective operation statistics */
 
   if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_COLLOP))
   {
-    for(i = 0; i < sum->collop_stat_num; i++)
+    n = markDump ? sum->collop_dirty_num : sum->collop_stat_num;
+    for(i = 0; i < n; i++)
     {
+      idx = markDump ? sum->collop_dirty[i] : i;
       VTGen_write_COLLECTIVE_OPERATION_SUMMARY(sum->gen, &time,
-	sum->collop_stat[i].cid,
-	sum->collop_stat[i].rid,
-	sum->collop_stat[i].scnt,
-	sum->collop_stat[i].rcnt,
-	sum->collop_stat[i].sent,
-	sum->collop_stat[i].recvd);
+	sum->collop_stat[idx].cid,
+	sum->collop_stat[idx].rid,
+	sum->collop_stat[idx].scnt,
+	sum->collop_stat[idx].rcnt,
+	sum->collop_stat[idx].sent,
+	sum->collop_stat[idx].recvd);
+      sum->collop_stat[idx].dirty = 0;
     }
+    sum->collop_dirty_num = 0;
   }
 
   /* dump file operation statistics */
 
   if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_FILEOP))
   {
-    for(i = 0; i < sum->fileop_stat_num; i++)
+    n = markDump ? sum->fileop_dirty_num : sum->fileop_stat_num;
+    for(i = 0; i < n; i++)
     {
+      idx = markDump ? sum->fileop_dirty[i] : i;
       VTGen_write_FILE_OPERATION_SUMMARY(sum->gen, &time,
-	sum->fileop_stat[i].fid,
-        sum->fileop_stat[i].nopen,
-        sum->fileop_stat[i].nclose,
-	sum->fileop_stat[i].nread,
-	sum->fileop_stat[i].nwrite,
-	sum->fileop_stat[i].nseek,
-	sum->fileop_stat[i].read,
-	sum->fileop_stat[i].wrote);
+	sum->fileop_stat[idx].fid,
+        sum->fileop_stat[idx].nopen,
+        sum->fileop_stat[idx].nclose,
+	sum->fileop_stat[idx].nread,
+	sum->fileop_stat[idx].nwrite,
+	sum->fileop_stat[idx].nseek,
+	sum->fileop_stat[idx].read,
+	sum->fileop_stat[idx].wrote);
+      sum->fileop_stat[idx].dirty = 0;
     }
+    sum->fileop_dirty_num = 0;
   }
 
   time = vt_pform_wtime();
@@ -763,12 +1169,18 @@ void VTSum_dump(VTSum* sum, uint8_t markDump)
 
   if (sum->next_dump != (uint64_t)-1)
     sum->next_dump = time + SumIntv;
+
+  VT_OVHD_END(VTThrdv[sum->tid], VT_OVHD_STAT, ovhd_time);
 }
 
 void VTSum_close(VTSum* sum)
 {
   /* dump statistics */
   VTSum_dump(sum, 0);
+
+  /* write calling-context tree */
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_CALLPATH))
+    cpath_write(sum);
 }
 
 void VTSum_delete(VTSum* sum)
@@ -777,6 +1189,16 @@ void VTSum_delete(VTSum* sum)
   {
     /* free function statistics */
     free(sum->func_stat);
+    free(sum->func_dirty);
+
+    /* free duration histograms */
+    if (sum->func_hist != NULL)
+    {
+      uint64_t i;
+      for (i = 0; i < sum->func_stat_num; i++)
+	free(sum->func_hist[i]);
+      free(sum->func_hist);
+    }
 
     /* free hash table for function statistics */
     hash_clear_func(sum);
@@ -789,6 +1211,7 @@ void VTSum_delete(VTSum* sum)
   {
     /* free message statistics */
     free(sum->msg_stat);
+    free(sum->msg_dirty);
 
     /* free hash table for message statistics */
     hash_clear_msg(sum);
@@ -798,6 +1221,7 @@ void VTSum_delete(VTSum* sum)
   {
     /* free collective operation statistics */
     free(sum->collop_stat);
+    free(sum->collop_dirty);
 
     /* free hash table for collective operation statistics */
     hash_clear_collop(sum);
@@ -807,11 +1231,20 @@ void VTSum_delete(VTSum* sum)
   {
     /* free file operation statistics */
     free(sum->fileop_stat);
+    free(sum->fileop_dirty);
 
     /* free hash table for file operation statistics */
     hash_clear_fileop(sum);
   }
 
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_CALLPATH))
+  {
+    /* free calling-context tree */
+    free(sum->cpath_node);
+    vt_htab_free(sum->cpath_htab);
+    free(sum->cpath_stack);
+  }
+
   /* free sum record */
   free(sum);
 }
@@ -826,17 +1259,23 @@ void VTSum_enter(VTSum* sum, uint64_t* time, uint32_t rid)
 
   VTSUM_CHECK(sum);
 
-  if ( (hn = hash_get_func(sum, rid)) )
-  {
-    stat_idx = hn->stat_idx;
-  }
-  else
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_FUNC))
   {
-    VTSUM_FUNC_STAT_ADD(sum, rid, stat_idx);
-    hash_put_func(sum, rid, stat_idx);
+    if ( (hn = hash_get_func(sum, rid)) )
+    {
+      stat_idx = hn->stat_idx;
+    }
+    else
+    {
+      VTSUM_FUNC_STAT_ADD(sum, rid, stat_idx);
+      hash_put_func(sum, rid, stat_idx);
+    }
+
+    VTSUM_STACK_PUSH(sum, stat_idx, time);
   }
 
-  VTSUM_STACK_PUSH(sum, stat_idx, time);
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_CALLPATH))
+    cpath_enter(sum, time, rid);
 
   VT_CHECK_DUMP(sum, time);
 }
@@ -845,7 +1284,11 @@ void VTSum_exit(VTSum* sum, uint64_t* time, uint32_t rid)
 {
   VTSUM_CHECK(sum);
 
-  VTSUM_STACK_POP(sum, time);
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_FUNC))
+    VTSUM_STACK_POP(sum, time);
+
+  if (VTSUM_IS_PROP_ON(sum, VT_SUM_PROP_CALLPATH))
+    cpath_exit(sum, time);
 
   VT_CHECK_DUMP(sum, time);
 }
@@ -866,6 +1309,7 @@ void VTSum_exit(VTSum* sum, uint64_t* time, uint32_t rid)
     VTSUM_MSG_STAT_ADD(_sum, _peer, _cid, _tag, _stat_idx); \
     hash_put_msg(_sum, _peer, _cid, _tag, _stat_idx);       \
   }                                                         \
+  VTSUM_MARK_DIRTY(_sum, msg, _stat_idx);                   \
 }
 
 void VTSum_msg_send(VTSum* sum, uint64_t* time, uint32_t dpid, uint32_t cid,
@@ -937,6 +1381,8 @@ void VTSum_collop(VTSum* sum, uint64_t* time, uint32_t rid, uint32_t cid,
     VTSUM_COLLOP_STAT_ADD(sum, lrid, lcid, stat_idx);
     hash_put_collop(sum, lrid, lcid, stat_idx);
   }
+
+  VTSUM_MARK_DIRTY(sum, collop, stat_idx);
   
   if ( sent > 0 )
   {
@@ -968,6 +1414,7 @@ void VTSum_collop(VTSum* sum, uint64_t* time, uint32_t rid, uint32_t cid,
     VTSUM_FILEOP_STAT_ADD(_sum, _fid, _stat_idx);           \
     hash_put_fileop(_sum, _fid, _stat_idx);                 \
   }                                                         \
+  VTSUM_MARK_DIRTY(_sum, fileop, _stat_idx);                \
 }
 
 void VTSum_fileop_open(VTSum* sum, uint64_t* time, uint32_t fid)
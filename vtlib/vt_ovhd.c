@@ -0,0 +1,132 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "vt_defs.h"
+#include "vt_env.h"
+#include "vt_error.h"
+#include "vt_otf_gen.h"
+#include "vt_ovhd.h"
+#include "vt_pform.h"
+#include "vt_thrd.h"
+#include "vt_trc.h"
+
+/* flag: overhead accounting enabled? */
+uint8_t vt_ovhd_on = 0;
+
+/* names of the overhead categories */
+static const char* ovhd_names[VT_OVHD_NUM] =
+{
+  "VT_OVHD_ENTER",
+  "VT_OVHD_EXIT",
+  "VT_OVHD_COUNTER",
+  "VT_OVHD_FLUSH",
+  "VT_OVHD_STAT",
+  "VT_OVHD_RFG",
+  "VT_OVHD_IOWRAP",
+  "VT_OVHD_MPIWRAP"
+};
+
+/* counter ids of the overhead categories */
+static uint32_t ovhd_cidv[VT_OVHD_NUM];
+
+void vt_ovhd_init()
+{
+  uint32_t gid;
+  uint32_t i;
+
+  /* write counter group name definition */
+  gid = vt_def_counter_group(VT_CURRENT_THREAD, "VampirTrace Overhead");
+
+  /* write counter definitions for the overhead categories */
+  for ( i = 0; i < VT_OVHD_NUM; i++ )
+  {
+    ovhd_cidv[i] = vt_def_counter(VT_CURRENT_THREAD, ovhd_names[i],
+                                  VT_CNTR_ACC | VT_CNTR_UNSIGNED, gid, "us");
+  }
+
+  vt_ovhd_on = 1;
+}
+
+void vt_ovhd_finalize(int tnum)
+{
+  FILE* ovhd_file;
+  char  ovhd_filename[1024];
+  uint64_t res = vt_pform_clockres();
+  uint64_t time = vt_pform_wtime();
+  uint64_t total = time - vt_start_time;
+  int i, j;
+
+  /* stop accounting */
+  vt_ovhd_on = 0;
+
+  /* write accounted overhead of each thread as counters */
+  for ( i = 0; i < tnum; i++ )
+  {
+    if ( VTTHRD_TRACE_STATUS(VTThrdv[i]) != VT_TRACE_ON ) continue;
+
+    for ( j = 0; j < VT_OVHD_NUM; j++ )
+    {
+      VTGen_write_COUNTER(VTTHRD_GEN(VTThrdv[i]), &time, ovhd_cidv[j],
+                          (uint64_t)((double)VTThrdv[i]->ovhd_time[j] * 1e6 /
+                                     (double)res));
+    }
+  }
+
+  /* compose summary file name */
+  if (vt_my_funique > 0)
+    snprintf(ovhd_filename, sizeof(ovhd_filename) - 1, "%s/%s_%u.%d.ovhd",
+             vt_env_gdir(), vt_env_fprefix(), vt_my_funique, vt_my_trace);
+  else
+    snprintf(ovhd_filename, sizeof(ovhd_filename) - 1, "%s/%s.%d.ovhd",
+             vt_env_gdir(), vt_env_fprefix(), vt_my_trace);
+
+  /* open summary file */
+  ovhd_file = fopen(ovhd_filename, "w");
+  if (ovhd_file == NULL)
+  {
+    vt_warning("Cannot open file %s", ovhd_filename);
+    return;
+  }
+
+  /* write summary of each thread; times are inclusive, i.e. nested
+     categories (e.g. VT_OVHD_FLUSH within VT_OVHD_ENTER) are contained */
+  fprintf(ovhd_file, "# VampirTrace overhead of process %d "
+                     "(run time %.6f s)\n",
+          vt_my_trace, (double)total / (double)res);
+  fprintf(ovhd_file, "# %-8s %-16s %14s %14s %12s %8s\n",
+          "thread", "category", "calls", "time [s]", "avg [us]", "%");
+
+  for ( i = 0; i < tnum; i++ )
+  {
+    for ( j = 0; j < VT_OVHD_NUM; j++ )
+    {
+      uint64_t calls = VTThrdv[i]->ovhd_calls[j];
+      double   secs = (double)VTThrdv[i]->ovhd_time[j] / (double)res;
+
+      if ( calls == 0 ) continue;
+
+      fprintf(ovhd_file, "  %-8d %-16s %14llu %14.6f %12.3f %8.3f\n",
+              i, ovhd_names[j], (unsigned long long)calls, secs,
+              secs * 1e6 / (double)calls,
+              total > 0 ? secs * 100.0 * (double)res / (double)total : 0.0);
+    }
+  }
+
+  /* close summary file */
+  fclose(ovhd_file);
+
+  vt_cntl_msg(2, "Wrote overhead summary file %s", ovhd_filename);
+}
@@ -0,0 +1,64 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#ifndef _VT_OVHD_H
+#define _VT_OVHD_H
+
+#ifdef __cplusplus
+#   define EXTERN extern "C"
+#else
+#   define EXTERN extern
+#endif
+
+#include "vt_inttypes.h"
+#include "vt_pform.h"
+
+/* categories of accounted tracer overhead (inclusive, i.e. the time of
+   nested categories, e.g. a buffer flush within vt_enter, is accounted to
+   both categories) */
+#define VT_OVHD_ENTER   0 /* vt_enter */
+#define VT_OVHD_EXIT    1 /* vt_exit */
+#define VT_OVHD_COUNTER 2 /* vt_update_counter */
+#define VT_OVHD_FLUSH   3 /* VTGen_flush */
+#define VT_OVHD_STAT    4 /* VTSum_dump */
+#define VT_OVHD_RFG     5 /* RFG region filter/group lookups */
+#define VT_OVHD_IOWRAP  6 /* I/O wrapper without the wrapped I/O call */
+#define VT_OVHD_MPIWRAP 7 /* MPI wrapper without the wrapped PMPI call */
+#define VT_OVHD_NUM     8
+
+/* flag: overhead accounting enabled? (VT_OVERHEAD) */
+EXTERN uint8_t vt_ovhd_on;
+
+EXTERN void vt_ovhd_init(void);
+EXTERN void vt_ovhd_finalize(int tnum);
+
+/* timestamp at the begin of an accounted section; 0, if accounting is off */
+#define VT_OVHD_BEGIN() (vt_ovhd_on ? vt_pform_wtime() : 0)
+
+/* add the time since _t0 to category _cat of thread object _thrd */
+#define VT_OVHD_ADD(_thrd, _cat, _t0) \
+  do { \
+    if (vt_ovhd_on) \
+      (_thrd)->ovhd_time[_cat] += vt_pform_wtime() - (_t0); \
+  } while (0)
+
+/* add the time since _t0 to category _cat of thread object _thrd and
+   count the call */
+#define VT_OVHD_END(_thrd, _cat, _t0) \
+  do { \
+    if (vt_ovhd_on) { \
+      (_thrd)->ovhd_time[_cat] += vt_pform_wtime() - (_t0); \
+      (_thrd)->ovhd_calls[_cat]++; \
+    } \
+  } while (0)
+
+#endif /* _VT_OVHD_H */
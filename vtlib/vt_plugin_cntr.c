@@ -10,6 +10,9 @@
  * See the file COPYING in the package base directory for details
  **/
 
+#include "config.h"
+
+#include "vt_atomic.h"
 #include "vt_plugin_cntr.h"
 #include "vt_plugin_cntr_int.h"
 #include "vt_pform.h"
@@ -42,8 +45,33 @@ struct vt_plugin {
 static struct vt_plugin** vt_plugin_handles = NULL;
 static uint32_t * nr_plugins = NULL;
 
-/* the maximal number of events a callback may produce */
-#define MAX_VALUES_CALLBACK 1024*1024
+/* the number of values a callback counter may buffer between two
+   drains (power of 2) */
+#define VT_PLUGIN_CNTR_RING_SIZE (64*1024)
+#define VT_PLUGIN_CNTR_RING_MASK (VT_PLUGIN_CNTR_RING_SIZE-1)
+
+/* single producer/single consumer ring buffer of a callback counter:
+   the plugin's monitor thread appends values (callback_function),
+   the traced thread drains them (vt_plugin_cntr_write_callback_data);
+   head and tail are free running indices, each written by one side only */
+struct vt_plugin_cntr_ring {
+  /* the values */
+  vt_plugin_cntr_timevalue * values;
+  /* the vt counter id */
+  uint32_t vt_counter_id;
+  /* number of values dropped, because the ring was full */
+  volatile uint32_t lost;
+  /* next value to write, only changed by the producer */
+  volatile uint32_t head;
+  /* keep head and tail on different cache lines */
+  char pad[64];
+  /* next value to read, only changed by the consumer */
+  volatile uint32_t tail;
+#if !defined(VT_HAVE_ATOMICS)
+  /* no memory barriers available, protect the indices by a mutex */
+  void * mutex;
+#endif /* VT_HAVE_ATOMICS */
+};
 
 /* whether plugins are used or not*/
 uint8_t vt_plugin_cntr_used = 0;
@@ -63,6 +91,8 @@ struct vt_plugin_single_counter {
   /* short cuts for getting values */
   uint64_t (*getValue)(int32_t);
   uint64_t (*getAllValues)(int32_t, vt_plugin_cntr_timevalue **);
+  /* values of callback counters */
+  struct vt_plugin_cntr_ring * ring;
 };
 
 /* used for per thread variables in VTThrd */
@@ -71,15 +101,13 @@ struct vt_plugin_cntr_defines{
   uint32_t * size_of_counters;
   /* per synch type, size_of ...*/
   struct vt_plugin_single_counter ** vt_plugin_vector;
-  /* last timestamp for callback, int per thread*/
-  uint64_t last_callback_get_for_thread;
-  /* current position in callback_values to write, int per thread */
-  uint32_t current_callback_write_position;
-  /* creates dummy thread for every thread that has a post mortem counter */
+  /* timestamp of the last written callback value */
+  uint64_t last_callback_timestamp;
+  /* number of callback values dropped, because they arrived too late */
+  uint32_t late_callback_values;
+  /* creates dummy thread for every thread that has a post mortem or
+     callback counter */
   uint32_t postmortem_dummy_thread_id;
-  /* callback stuff */
-  vt_plugin_cntr_timevalue * callback_values;
-  void * callback_mutex;
 };
 
 
@@ -615,25 +643,13 @@ static void add_events(struct vt_plugin current_plugin, VTThrd * thrd) {
       continue;
     }
     /* currently no key value :( */
+#if !(defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
     if (current_plugin.info.synch == VT_PLUGIN_CNTR_ASYNCH_CALLBACK) {
-      if (*current_size == 0) {
-        /* allocate resources */
-#if (defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
-        plugin_cntr_defines->callback_values=malloc(
-            MAX_VALUES_CALLBACK*sizeof(vt_plugin_cntr_timevalue));
-        VTThrd_createMutex((VTThrdMutex **) &(plugin_cntr_defines->callback_mutex));
-#else
-        vt_error_msg(
-                    "callback events need thread support, you might use -vt:mt or -vt:hyb\n");
-        continue;
-#endif  /* VT_MT || VT_HYB || VT_JAVA */
-      }
-      else{
-        vt_error_msg(
-            "currently only one callback event per thread can be executed\n");
-        continue;
-      }
+      vt_error_msg(
+                  "callback events need thread support, you might use -vt:mt or -vt:hyb\n");
+      continue;
     }
+#endif  /* VT_MT || VT_HYB || VT_JAVA */
     /* add counter */
     current[*current_size].from_plugin_id
         = current_plugin.info.add_counter(current_plugin.selected_events[j]);
@@ -659,16 +675,20 @@ static void add_events(struct vt_plugin current_plugin, VTThrd * thrd) {
       current[*current_size].getValue
           = current_plugin.info.get_current_value;
     if ((current_plugin.info.synch == VT_PLUGIN_CNTR_ASYNCH_EVENT) ||
-        (current_plugin.info.synch == VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM)){
+        (current_plugin.info.synch == VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM))
       /* these have to implement getAllValues */
       current[*current_size].getAllValues
           = current_plugin.info.get_all_values;
+    /* asynchronous values are written to a dummy thread */
+    if (current_plugin.info.synch != VT_PLUGIN_CNTR_SYNCH){
       /* if there's no dummy thread (will be removed for 5.10) */
       if (plugin_cntr_defines->postmortem_dummy_thread_id==0){
         /* create a dummy thread */
         thread_index = VTThrd_createNewThreadId();
         VTThrd_create(thread_index, VT_MY_THREAD, "Plugin Counter", 1);
         VTThrd_open(thread_index);
+        /* it's closed by this thread (see VTThrd_close) */
+        VTThrdv[thread_index]->plugin_cntr_dummy = 1;
         plugin_cntr_defines->postmortem_dummy_thread_id=thread_index;
       } else
       {
@@ -677,14 +697,23 @@ static void add_events(struct vt_plugin current_plugin, VTThrd * thrd) {
       }
     }
     if (current_plugin.info.synch == VT_PLUGIN_CNTR_ASYNCH_CALLBACK) {
-      /* callback should set the callback function */
-      plugin_cntr_defines->callback_values = malloc(
-          MAX_VALUES_CALLBACK * sizeof(vt_plugin_cntr_timevalue));
+      /* every callback counter gets its own ring buffer, which is
+         passed to the callback function as ID */
+      struct vt_plugin_cntr_ring * ring =
+        calloc(1, sizeof(struct vt_plugin_cntr_ring));
+      vt_assert(ring!=NULL);
+      ring->values = malloc(
+          VT_PLUGIN_CNTR_RING_SIZE * sizeof(vt_plugin_cntr_timevalue));
+      vt_assert(ring->values!=NULL);
+      ring->vt_counter_id = current[*current_size].vt_counter_id;
+#if !defined(VT_HAVE_ATOMICS)
+      VTThrd_createMutex((VTThrdMutex **) &(ring->mutex));
+#endif /* VT_HAVE_ATOMICS */
+      current[*current_size].ring = ring;
       current[*current_size].thread_incrementing_id = j;
+      /* callback should set the callback function */
       current_plugin.info.set_callback_function(
-          plugin_cntr_defines,
-          current[*current_size].from_plugin_id, callback_function);
-
+          ring, current[*current_size].from_plugin_id, callback_function);
     }
 
     (*current_size)++;
@@ -727,82 +756,190 @@ void vt_plugin_cntr_thread_exit(VTThrd * thrd) {
 
   vt_plugin_cntr_thread_disable_counters(thrd);
   /* free per thread resources */
-  if (defines->size_of_counters!=NULL)
-    free (defines->size_of_counters);
   if (defines->vt_plugin_vector!=NULL){
+    if (defines->size_of_counters!=NULL &&
+        defines->vt_plugin_vector[VT_PLUGIN_CNTR_ASYNCH_CALLBACK]!=NULL){
+      for (i=0;i<defines->size_of_counters[VT_PLUGIN_CNTR_ASYNCH_CALLBACK];i++){
+        struct vt_plugin_cntr_ring * ring =
+          defines->vt_plugin_vector[VT_PLUGIN_CNTR_ASYNCH_CALLBACK][i].ring;
+        if (ring==NULL) continue;
+#if !defined(VT_HAVE_ATOMICS)
+        VTThrd_deleteMutex((VTThrdMutex **) &(ring->mutex));
+#endif /* VT_HAVE_ATOMICS */
+        free(ring->values);
+        free(ring);
+      }
+    }
     for (i=0;i<VT_PLUGIN_CNTR_SYNCH_TYPE_MAX;i++)
       if (defines->vt_plugin_vector[i]!=NULL)
         free(defines->vt_plugin_vector[i]);
     free (defines->vt_plugin_vector);
   }
-  if (defines->callback_values!=NULL)
-    free (defines->callback_values);
-#if (defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
-  if (defines->callback_mutex!=NULL)
-    VTThrd_deleteMutex((VTThrdMutex **) &(defines->callback_mutex));
-#endif  /* VT_MT || VT_HYB || VT_JAVA */
+  if (defines->size_of_counters!=NULL)
+    free (defines->size_of_counters);
   free(defines);
 
 }
 
 /**
  * This is called by a callback plugin
- * It writes data to a data buffer, which is later "collected"
- * with write_callback_data by vampir_trace
+ * It appends a value to the ring buffer of the counter (ID), which is
+ * later drained with write_callback_data by vampir_trace
+ * The ring is only written by one thread, so no lock is needed
  */
 int32_t callback_function(void * ID, vt_plugin_cntr_timevalue tv) {
-  struct vt_plugin_cntr_defines * defines =
-      (struct vt_plugin_cntr_defines *) ID;
-  vt_plugin_cntr_timevalue * timeList;
-  if (defines->current_callback_write_position>=MAX_VALUES_CALLBACK) return -1;
-  timeList = defines->callback_values;
-#if (defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
-  VTThrd_lock((VTThrdMutex **) &defines->callback_mutex);
-#endif  /* VT_MT || VT_HYB || VT_JAVA */
-  timeList[defines->current_callback_write_position++] = tv;
-#if (defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
-  VTThrd_unlock((VTThrdMutex **) &defines->callback_mutex);
-#endif  /* VT_MT || VT_HYB || VT_JAVA */
-  return 0;
+  struct vt_plugin_cntr_ring * ring = (struct vt_plugin_cntr_ring *) ID;
+  uint32_t head;
+  int32_t ret = 0;
+#if !defined(VT_HAVE_ATOMICS)
+  VTThrd_lock((VTThrdMutex **) &ring->mutex);
+#endif /* VT_HAVE_ATOMICS */
+  head = ring->head;
+  if (head - ring->tail >= VT_PLUGIN_CNTR_RING_SIZE) {
+    /* full, the traced thread didn't drain it in time */
+    ring->lost++;
+    ret = -1;
+  }
+  else {
+    ring->values[head & VT_PLUGIN_CNTR_RING_MASK] = tv;
+    /* the value has to be visible before the new head */
+    VT_ATOMIC_BARRIER();
+    ring->head = head + 1;
+  }
+#if !defined(VT_HAVE_ATOMICS)
+  VTThrd_unlock((VTThrdMutex **) &ring->mutex);
+#endif /* VT_HAVE_ATOMICS */
+  return ret;
 }
 
 /**
  * write collected callback data to otf
- * this has to be done in a mutex. currently the mutex is per thread,
- * later it might be done per counter of a thread?
+ * The values of all callback counters of the thread are merged by their
+ * timestamps and written to its dummy thread. Unless force is set, this
+ * is only done if a ring is at least half full, so the values are
+ * written in batches rather than at every event.
  */
-void vt_plugin_cntr_write_callback_data(uint64_t time, VTThrd * thrd) {
-  uint32_t counterID, i, k;
+void vt_plugin_cntr_write_callback_data(VTThrd * thrd, uint8_t force) {
+  uint32_t heads[VT_PLUGIN_COUNTERS_PER_THREAD];
+  uint32_t tails[VT_PLUGIN_COUNTERS_PER_THREAD];
+  struct vt_plugin_single_counter * counters;
+  struct vt_plugin_cntr_ring * ring;
+  vt_plugin_cntr_timevalue tv;
+  uint32_t num, selected, i;
   struct vt_plugin_cntr_defines * plugin_cntr_defines =
     (struct vt_plugin_cntr_defines * )thrd->plugin_cntr_defines;
 
   if (plugin_cntr_defines==NULL)
-  if (plugin_cntr_defines->size_of_counters[VT_PLUGIN_CNTR_ASYNCH_CALLBACK] == 0)
     return;
-#if (defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
-  VTThrd_lock((VTThrdMutex **) &plugin_cntr_defines->callback_mutex);
-#endif  /* VT_MT || VT_HYB || VT_JAVA */
-  for (i = 0;
-  i < plugin_cntr_defines->size_of_counters[VT_PLUGIN_CNTR_ASYNCH_CALLBACK];
-  i++) {
-    vt_plugin_cntr_timevalue * values = plugin_cntr_defines->callback_values;
-    counterID = plugin_cntr_defines->vt_plugin_vector[VT_PLUGIN_CNTR_ASYNCH_CALLBACK]
-                                 [i].vt_counter_id;
-    k = 0;
-    while ((k < plugin_cntr_defines->current_callback_write_position)) {
-      if ((values[k].timestamp <= time) && (values[k].timestamp
-          > plugin_cntr_defines->last_callback_get_for_thread))
-        vt_count(VT_MY_THREAD,&values[k].timestamp, counterID, values[k].value);
-      else
+  num = plugin_cntr_defines->size_of_counters[VT_PLUGIN_CNTR_ASYNCH_CALLBACK];
+  if (num == 0)
+    return;
+  counters = plugin_cntr_defines->vt_plugin_vector[VT_PLUGIN_CNTR_ASYNCH_CALLBACK];
+
+  if (!force) {
+    for (i = 0; i < num; i++) {
+      ring = counters[i].ring;
+      if (ring->head - ring->tail >= VT_PLUGIN_CNTR_RING_SIZE / 2)
         break;
-      k++;
     }
-    plugin_cntr_defines->current_callback_write_position = 0;
-    plugin_cntr_defines->last_callback_get_for_thread = time;
+    if (i == num)
+      return;
+  }
+
+  /* get the values available now */
+  for (i = 0; i < num; i++) {
+    ring = counters[i].ring;
+#if !defined(VT_HAVE_ATOMICS)
+    VTThrd_lock((VTThrdMutex **) &ring->mutex);
+#endif /* VT_HAVE_ATOMICS */
+    heads[i] = ring->head;
+    tails[i] = ring->tail;
+#if !defined(VT_HAVE_ATOMICS)
+    VTThrd_unlock((VTThrdMutex **) &ring->mutex);
+#endif /* VT_HAVE_ATOMICS */
+  }
+  /* read the values not before their heads */
+  VT_ATOMIC_BARRIER();
+
+  while (1) {
+    /* select the next value in time */
+    selected = num;
+    for (i = 0; i < num; i++) {
+      if (tails[i] == heads[i]) continue;
+      if (selected == num ||
+          counters[i].ring->values[tails[i] & VT_PLUGIN_CNTR_RING_MASK].timestamp <
+          counters[selected].ring->values[tails[selected] & VT_PLUGIN_CNTR_RING_MASK].timestamp)
+        selected = i;
+    }
+    /* if there's no selected value we're done */
+    if (selected == num) break;
+
+    ring = counters[selected].ring;
+    tv = ring->values[tails[selected] & VT_PLUGIN_CNTR_RING_MASK];
+    tails[selected]++;
+
+    /* values older than the ones already written would break the order
+       of the dummy thread's records */
+    if (tv.timestamp < plugin_cntr_defines->last_callback_timestamp) {
+      plugin_cntr_defines->late_callback_values++;
+      continue;
+    }
+    vt_count(plugin_cntr_defines->postmortem_dummy_thread_id,
+        &tv.timestamp, ring->vt_counter_id, tv.value);
+    plugin_cntr_defines->last_callback_timestamp = tv.timestamp;
+  }
+
+  /* the values have to be read before their slots are released */
+  VT_ATOMIC_BARRIER();
+  for (i = 0; i < num; i++) {
+    ring = counters[i].ring;
+#if !defined(VT_HAVE_ATOMICS)
+    VTThrd_lock((VTThrdMutex **) &ring->mutex);
+#endif /* VT_HAVE_ATOMICS */
+    ring->tail = tails[i];
+#if !defined(VT_HAVE_ATOMICS)
+    VTThrd_unlock((VTThrdMutex **) &ring->mutex);
+#endif /* VT_HAVE_ATOMICS */
+  }
+
+  if (force) {
+    uint32_t lost = 0;
+    for (i = 0; i < num; i++)
+      lost += counters[i].ring->lost;
+    if (lost > 0 || plugin_cntr_defines->late_callback_values > 0)
+      vt_warning("Thread %s%s lost %u plugin counter values (buffer full), "
+                 "%u arrived too late",
+                 thrd->name, thrd->name_suffix, lost,
+                 plugin_cntr_defines->late_callback_values);
   }
-#if (defined(VT_MT) || defined (VT_HYB) || defined(VT_JAVA))
-  VTThrd_unlock((VTThrdMutex **) &plugin_cntr_defines->callback_mutex);
-#endif  /* VT_MT || VT_HYB || VT_JAVA */
+}
+
+/* compare the timestamps of two values (qsort) */
+static int post_mortem_value_cmp(const void * a, const void * b) {
+  uint64_t ta = ((const vt_plugin_cntr_timevalue *) a)->timestamp;
+  uint64_t tb = ((const vt_plugin_cntr_timevalue *) b)->timestamp;
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+/* move the counter at position pos of the heap down, until the heap is
+   ordered by the timestamps of the counters' next values again */
+static void post_mortem_heap_down(uint32_t * heap, uint32_t heap_size,
+    uint32_t pos, vt_plugin_cntr_timevalue ** current_time_values) {
+  uint32_t counter = heap[pos];
+  uint64_t timestamp = current_time_values[counter]->timestamp;
+  uint32_t child;
+
+  while ((child = 2 * pos + 1) < heap_size) {
+    if (child + 1 < heap_size &&
+        current_time_values[heap[child + 1]]->timestamp <
+        current_time_values[heap[child]]->timestamp)
+      child++;
+    if (current_time_values[heap[child]]->timestamp >= timestamp)
+      break;
+    heap[pos] = heap[child];
+    pos = child;
+  }
+  heap[pos] = counter;
 }
 
 /* may be called per thread */
@@ -810,15 +947,13 @@ void vt_plugin_cntr_final_write_post_mortem(VTThrd * thrd){
   uint32_t counter_index;
   vt_plugin_cntr_timevalue ** time_values;
   vt_plugin_cntr_timevalue ** current_time_values;
-  vt_plugin_cntr_timevalue * selected_time_value;
-  uint32_t selected_counter=0;
   uint32_t number_of_counters;
-  vt_plugin_cntr_timevalue tmp_time_value;
   uint64_t * number_of_values;
-  uint64_t i,j;
-  int change;
-  uint64_t last_timestamp=0;
-  uint32_t count_id;
+  uint32_t * heap;
+  uint32_t heap_size = 0;
+  uint64_t i;
+  VTThrd * dummy_thrd;
+  struct vt_plugin_single_counter * counters;
   struct vt_plugin_cntr_defines * plugin_cntr_defines =
     (struct vt_plugin_cntr_defines * )thrd->plugin_cntr_defines;
 
@@ -831,10 +966,16 @@ void vt_plugin_cntr_final_write_post_mortem(VTThrd * thrd){
   /* for all post_mortem counters */
   number_of_counters=
     plugin_cntr_defines->size_of_counters[VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM];
+  counters=
+    plugin_cntr_defines->vt_plugin_vector[VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM];
+  dummy_thrd=VTThrdv[plugin_cntr_defines->postmortem_dummy_thread_id];
   number_of_values=calloc(number_of_counters,sizeof(uint64_t));
   time_values=calloc(number_of_counters,sizeof(vt_plugin_cntr_timevalue *));
   current_time_values=calloc(number_of_counters,
       sizeof(vt_plugin_cntr_timevalue *));
+  heap=calloc(number_of_counters,sizeof(uint32_t));
+  vt_assert(number_of_values!=NULL && time_values!=NULL &&
+            current_time_values!=NULL && heap!=NULL);
 
   /* for all counters of this thread */
   for(counter_index=0;
@@ -842,85 +983,76 @@ void vt_plugin_cntr_final_write_post_mortem(VTThrd * thrd){
     counter_index++){
    /* get data */
     number_of_values[counter_index]=
-      plugin_cntr_defines->vt_plugin_vector
-        [VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM][counter_index].getAllValues(
-            plugin_cntr_defines->vt_plugin_vector
-            [VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM][counter_index].from_plugin_id,
+      counters[counter_index].getAllValues(
+          counters[counter_index].from_plugin_id,
           &time_values[counter_index]
       );
 
-    /* sort data  if there is some*/
-    if (number_of_values[counter_index]!=0){
-      for (i=number_of_values[counter_index]-1;i!=(uint64_t)-1;i--){
-        change=0;
-        for (j=0;j<i;j++){
-          if (time_values[counter_index][j].timestamp>time_values[counter_index][j+1].timestamp){
-            tmp_time_value=time_values[counter_index][j];
-            time_values[counter_index][j]=time_values[counter_index][j+1];
-            time_values[counter_index][j+1]=tmp_time_value;
-            change=1;
-          }
-        }
-      if (!change) break;
-      }
-      /* select the first event for all counters */
-      current_time_values[counter_index]=time_values[counter_index];
-    }
-    else{
-      current_time_values[counter_index]=NULL;
-    }
+    if (number_of_values[counter_index]==0)
+      continue;
+
+    /* sort data, if the plugin didn't */
+    for (i=1;i<number_of_values[counter_index];i++)
+      if (time_values[counter_index][i-1].timestamp>
+          time_values[counter_index][i].timestamp)
+        break;
+    if (i<number_of_values[counter_index])
+      qsort(time_values[counter_index],
+            (size_t)number_of_values[counter_index],
+            sizeof(vt_plugin_cntr_timevalue), post_mortem_value_cmp);
+
+    /* select the first event of the counter */
+    current_time_values[counter_index]=time_values[counter_index];
+    heap[heap_size++]=counter_index;
   }
-  /* sort all results returned */
-  while (1){
-    /* select the next in time, NULL means none selected/counter
-     * has no more data
-     */
-    selected_time_value=NULL;
-    for(counter_index=0; counter_index<number_of_counters; counter_index++){
-      /* select one if none is selected */
-      if (selected_time_value==NULL){
-        if(current_time_values[counter_index]!=NULL){
-          selected_time_value=current_time_values[counter_index];
-          selected_counter=counter_index;
-        }
-      }
-      /* compare timestamps */
-      else{
-        if(current_time_values[counter_index]!=NULL)
-          if (selected_time_value->timestamp>current_time_values[counter_index]->timestamp){
-            selected_time_value=current_time_values[counter_index];
-            selected_counter=counter_index;
-          }
 
-      }
-    }
-    /* if there's no selected event we're done */
-    if (selected_time_value==NULL) break;
+  /* merge the values of all counters by a heap of the counters, which is
+     ordered by the timestamps of their next values */
+  for (counter_index=heap_size/2;counter_index-->0;)
+    post_mortem_heap_down(heap, heap_size, counter_index,
+                          current_time_values);
+
+  while (heap_size>0){
+    /* stop, if the dummy thread's trace was switched off (e.g. because
+       the maximum number of buffer flushes was reached) */
+    if (VTTHRD_TRACE_STATUS(dummy_thrd) != VT_TRACE_ON) break;
 
-    /* otherwise we write the event */
-    count_id = plugin_cntr_defines->vt_plugin_vector
-      [VT_PLUGIN_CNTR_ASYNCH_POST_MORTEM][selected_counter].vt_counter_id;
+    /* write the next event in time */
+    counter_index=heap[0];
     vt_count(
         plugin_cntr_defines->postmortem_dummy_thread_id,
-        &(selected_time_value->timestamp),
-        count_id,
-        selected_time_value->value);
+        &(current_time_values[counter_index]->timestamp),
+        counters[counter_index].vt_counter_id,
+        current_time_values[counter_index]->value);
+
+    /* move to the counter's next value or remove the counter from the
+       heap, if it has no more data */
+    if (--number_of_values[counter_index]>0)
+      current_time_values[counter_index]++;
+    else
+      heap[0]=heap[--heap_size];
+    if (heap_size>0)
+      post_mortem_heap_down(heap, heap_size, 0, current_time_values);
+  }
 
-    last_timestamp=selected_time_value->timestamp;
+  /* free allocated stuff */
+  for (counter_index=0;counter_index<number_of_counters;counter_index++)
+    if (time_values[counter_index]!=NULL)
+      free(time_values[counter_index]);
+  free(time_values);
+  free(current_time_values);
+  free(number_of_values);
+  free(heap);
+}
 
-    /* and move the pointer to the next element */
-    current_time_values[selected_counter]++;
+VTThrd * vt_plugin_cntr_get_dummy_thread(VTThrd * thrd) {
+  struct vt_plugin_cntr_defines * plugin_cntr_defines =
+    (struct vt_plugin_cntr_defines * )thrd->plugin_cntr_defines;
 
-    /* but if there is no more data for this counter, we set it to NULL */
-    if (time_values[selected_counter]+number_of_values[selected_counter]<=current_time_values[selected_counter])
-      current_time_values[selected_counter]=NULL;
-  }
-    /* free allocated stuff */
-    for (i=0;i<number_of_counters;i++){
-      free(time_values[i]);
-    }
-    free(time_values);
-    free(number_of_values);
+  if (plugin_cntr_defines==NULL ||
+      plugin_cntr_defines->postmortem_dummy_thread_id==0)
+    return NULL;
+  return VTThrdv[plugin_cntr_defines->postmortem_dummy_thread_id];
 }
 
 int vt_plugin_cntr_is_registered_monitor_thread() {
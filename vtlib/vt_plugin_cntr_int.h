@@ -35,10 +35,10 @@ uint64_t vt_plugin_cntr_get_synch_value(VTThrd * thrd, int nr, uint32_t * cid,
     uint64_t * value);
 
 /**
- * write all callback data for threadID, which occured between the
- * last call of this function and time
+ * write the callback data collected for thrd since the last call of
+ * this function; unless force is set, only if a buffer is half full
  */
-void vt_plugin_cntr_write_callback_data(uint64_t time, VTThrd * thrd);
+void vt_plugin_cntr_write_callback_data(VTThrd * thrd, uint8_t force);
 
 /**
  * get the asynch values of postmortem counters
@@ -93,6 +93,12 @@ int vt_plugin_cntr_is_registered_monitor_thread(void);
  */
 void vt_plugin_cntr_final_write_post_mortem(VTThrd * thrd);
 
+/**
+ * get the dummy thread, to which the asynchronous counters of thrd are
+ * written; NULL if there's none
+ */
+VTThrd * vt_plugin_cntr_get_dummy_thread(VTThrd * thrd);
+
 
 
 #endif /* _VT_PLUGIN_CNTR_INT_H */
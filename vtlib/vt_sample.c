@@ -0,0 +1,386 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "config.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "vt_comp.h"
+#include "vt_defs.h"
+#include "vt_env.h"
+#include "vt_error.h"
+#include "vt_iowrap.h"
+#include "vt_otf_gen.h"
+#include "vt_pform.h"
+#include "vt_sample.h"
+#include "vt_thrd.h"
+#include "vt_trc.h"
+
+/* Statistical sampling (VT_SAMPLE_INTV):
+   A timer per thread (CPU time) sends SIGPROF. The signal handler stores
+   the timestamp and the return addresses of the call stack in a pending
+   sample; it doesn't touch the trace buffer, because the thread might be
+   inside of VampirTrace. The pending samples are written by the thread
+   itself at the next ENTER/LEAVE (e.g. of an MPI or I/O wrapper) and at
+   the end: the sampled call path is compared with the previous one, and
+   ENTER/LEAVE records are written for the functions which appeared or
+   disappeared. Samples are only taken, if no region recorded by
+   instrumentation or a library wrapper is active above the sampled
+   functions.
+   The signal handler walks the call stack along the frame pointers of
+   the interrupted context (backtrace() isn't async-signal-safe: the
+   unwinder takes locks of the dynamic loader and may allocate memory).
+   It only follows frame pointers within the thread's stack, so it never
+   reads unmapped memory; functions compiled without frame pointers hide
+   their callers from the samples, though. */
+
+/* max. number of frames per sample */
+#define VT_SAMPLE_MAX_DEPTH 64
+
+/* registers of the interrupted context */
+#if defined(__x86_64__)
+# define VT_SAMPLE_UC_PC(uc) ((void*)(uc)->uc_mcontext.gregs[REG_RIP])
+# define VT_SAMPLE_UC_FP(uc) ((void**)(uc)->uc_mcontext.gregs[REG_RBP])
+# define VT_SAMPLE_UC_SP(uc) ((char*)(uc)->uc_mcontext.gregs[REG_RSP])
+#elif defined(__i386__)
+# define VT_SAMPLE_UC_PC(uc) ((void*)(uc)->uc_mcontext.gregs[REG_EIP])
+# define VT_SAMPLE_UC_FP(uc) ((void**)(uc)->uc_mcontext.gregs[REG_EBP])
+# define VT_SAMPLE_UC_SP(uc) ((char*)(uc)->uc_mcontext.gregs[REG_ESP])
+#elif defined(__aarch64__)
+# define VT_SAMPLE_UC_PC(uc) ((void*)(uc)->uc_mcontext.pc)
+# define VT_SAMPLE_UC_FP(uc) ((void**)(uc)->uc_mcontext.regs[29])
+# define VT_SAMPLE_UC_SP(uc) ((char*)(uc)->uc_mcontext.sp)
+#else
+# error "Statistical sampling isn't supported on this platform"
+#endif
+
+/* max. number of pending samples per thread */
+#define VT_SAMPLE_PENDING 256
+
+#if defined(SIGEV_THREAD_ID) && !defined(sigev_notify_thread_id)
+# define sigev_notify_thread_id _sigev_un._tid
+#endif /* SIGEV_THREAD_ID && !sigev_notify_thread_id */
+
+struct vt_sample_rec
+{
+  uint64_t time;
+  int      depth;
+  void*    addrv[VT_SAMPLE_MAX_DEPTH];
+};
+
+struct vt_sample
+{
+  timer_t  timer;                      /* sampling timer */
+  char*    stack_end;                  /* end of the thread's stack */
+  volatile uint32_t head;              /* next pending sample to store
+                                          (by the signal handler) */
+  volatile uint32_t tail;              /* next pending sample to write */
+  uint32_t lost;                       /* number of dropped samples */
+  int      top;                        /* call stack level at which
+                                          samples are taken */
+  uint32_t depth;                      /* number of sampled regions */
+  uint32_t ridv[VT_SAMPLE_MAX_DEPTH];  /* sampled regions, outermost
+                                          first */
+  struct vt_sample_rec recv[VT_SAMPLE_PENDING];
+};
+
+static uint8_t sample_handler_installed = 0;
+
+/* get the end of the stack mapping which contains the calling thread's
+   stack; NULL, if it's unknown */
+static char* vt_sample_stack_end(uint32_t tid)
+{
+  FILE* maps;
+  char line[4096];
+  unsigned long lo, hi;
+  unsigned long here = (unsigned long)line;
+  char* end = NULL;
+
+  VT_SUSPEND_IO_TRACING(tid);
+
+  if ( (maps = fopen("/proc/self/maps", "r")) != NULL )
+  {
+    while ( fgets(line, sizeof(line), maps) != NULL )
+    {
+      if ( sscanf(line, "%lx-%lx", &lo, &hi) == 2 &&
+           lo <= here && here < hi )
+      {
+        end = (char*)hi;
+        break;
+      }
+    }
+    fclose(maps);
+  }
+
+  VT_RESUME_IO_TRACING(tid);
+
+  return end;
+}
+
+/* walk the call stack of the interrupted context along the frame
+   pointers; the first address is the interrupted instruction, the
+   following ones are return addresses */
+static int vt_sample_walk(ucontext_t* uc, char* stack_end, void** addrv)
+{
+  char* sp = VT_SAMPLE_UC_SP(uc);
+  void** fp = VT_SAMPLE_UC_FP(uc);
+  int n = 0;
+
+  addrv[n++] = VT_SAMPLE_UC_PC(uc);
+
+  /* a frame record (caller's frame pointer, return address) has to lie
+     between the stack pointer and the end of the stack */
+  while ( n < VT_SAMPLE_MAX_DEPTH && stack_end != NULL &&
+          (char*)fp >= sp && (char*)(fp + 2) <= stack_end &&
+          (unsigned long)fp % sizeof(void*) == 0 )
+  {
+    void** next = (void**)fp[0];
+
+    if ( fp[1] == NULL ) break;
+    addrv[n++] = fp[1];
+
+    /* the callers' frames lie above */
+    if ( next <= fp ) break;
+    fp = next;
+  }
+
+  return n;
+}
+
+static void vt_sample_handler(int signum, siginfo_t* info, void* context)
+{
+  VTThrd* thrd;
+  struct vt_sample* s;
+  struct vt_sample_rec* rec;
+  int save_errno = errno;
+
+  (void)signum;
+  (void)info;
+
+  if ( !vt_is_alive ) return;
+
+  thrd = VTThrdv[VT_MY_THREAD];
+  if ( thrd == NULL || (s = thrd->sample) == NULL ) return;
+
+  /* don't sample inside of regions entered above the sampled ones */
+  if ( VTTHRD_TRACE_STATUS(thrd) != VT_TRACE_ON ||
+       VTTHRD_STACK_LEVEL(thrd) != s->top ) return;
+
+  if ( s->head - s->tail >= VT_SAMPLE_PENDING )
+  {
+    s->lost++;
+    return;
+  }
+
+  rec = &(s->recv[s->head % VT_SAMPLE_PENDING]);
+  rec->time = vt_pform_wtime();
+  rec->depth = vt_sample_walk((ucontext_t*)context, s->stack_end,
+                              rec->addrv);
+
+  s->head++;
+
+  errno = save_errno;
+}
+
+static void vt_sample_apply(uint32_t tid, struct vt_sample* s,
+                            uint64_t* time, uint32_t* ridv, uint32_t depth)
+{
+  VTThrd* thrd = VTThrdv[tid];
+  uint32_t i = 0;
+
+  /* skip common part of the previous and the current call path */
+  while ( i < s->depth && i < depth && s->ridv[i] == ridv[i] )
+    i++;
+
+  /* leave regions which are no longer on the call stack */
+  while ( s->depth > i )
+  {
+    VTGen_write_LEAVE(VTTHRD_GEN(thrd), time, 0, 0);
+    VTTHRD_STACK_POP(thrd);
+    s->depth--;
+  }
+
+  /* enter regions which were called since the previous sample */
+  for ( ; i < depth; i++ )
+  {
+    VTTHRD_STACK_PUSH(thrd);
+    VTGen_write_ENTER(VTTHRD_GEN(thrd), time, ridv[i], 0);
+    s->ridv[i] = ridv[i];
+    s->depth++;
+  }
+
+  s->top = VTTHRD_STACK_LEVEL(thrd);
+}
+
+void vt_sample_thread_init(uint32_t tid)
+{
+  struct vt_sample* s;
+  struct sigevent sev;
+  struct itimerspec its;
+  int intv = vt_env_sample_intv();
+
+  if ( intv == 0 ) return;
+
+  /* install signal handler, if not yet done (by the master thread, while
+     VampirTrace is initialized) */
+  if ( !sample_handler_installed )
+  {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = vt_sample_handler;
+    sa.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if ( sigaction(SIGPROF, &sa, NULL) != 0 )
+      vt_error_msg("sigaction: %s", strerror(errno));
+
+    sample_handler_installed = 1;
+  }
+
+  s = (struct vt_sample*)calloc(1, sizeof(struct vt_sample));
+  if ( s == NULL )
+    vt_error();
+
+  s->top = VTTHRD_STACK_LEVEL(VTThrdv[tid]);
+
+  /* samples without the stack end contain the interrupted function only */
+  s->stack_end = vt_sample_stack_end(tid);
+  if ( s->stack_end == NULL )
+  {
+    vt_warning("Could not determine the stack of thread #%u; samples "
+               "contain the interrupted function only", tid);
+  }
+
+  /* create timer which sends SIGPROF to this thread */
+
+  memset(&sev, 0, sizeof(sev));
+  sev.sigev_signo = SIGPROF;
+#if defined(SIGEV_THREAD_ID)
+  sev.sigev_notify = SIGEV_THREAD_ID;
+  sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+  if ( timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &(s->timer)) != 0 )
+#else /* SIGEV_THREAD_ID */
+  /* without thread-directed signals only the master thread of a
+     single-threaded program can be sampled */
+# if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
+  if ( tid == 0 )
+    vt_warning("Sampling of threads is not supported on this platform; "
+               "ignoring VT_SAMPLE_INTV");
+  free(s);
+  return;
+# endif /* VT_MT || VT_HYB || VT_JAVA */
+  sev.sigev_notify = SIGEV_SIGNAL;
+  if ( timer_create(CLOCK_PROCESS_CPUTIME_ID, &sev, &(s->timer)) != 0 )
+#endif /* SIGEV_THREAD_ID */
+  {
+    vt_warning("Could not create sampling timer: %s", strerror(errno));
+    free(s);
+    return;
+  }
+
+  VTThrdv[tid]->sample = s;
+
+  /* start timer */
+
+  its.it_interval.tv_sec = intv / 1000000;
+  its.it_interval.tv_nsec = (intv % 1000000) * 1000;
+  its.it_value = its.it_interval;
+
+  if ( timer_settime(s->timer, 0, &its, NULL) != 0 )
+    vt_error_msg("timer_settime: %s", strerror(errno));
+
+  vt_cntl_msg(2, "Started sampling of thread #%u every %i usec", tid, intv);
+}
+
+void vt_sample_finalize()
+{
+  uint64_t time;
+  uint32_t i;
+
+  if ( !sample_handler_installed ) return;
+
+  /* stop sampling; pending signals will be ignored */
+  signal(SIGPROF, SIG_IGN);
+  sample_handler_installed = 0;
+
+  time = vt_pform_wtime();
+
+  for ( i = 0; i < VTThrdn; i++ )
+  {
+    struct vt_sample* s;
+
+    if ( VTThrdv[i] == NULL || (s = VTThrdv[i]->sample) == NULL )
+      continue;
+
+    timer_delete(s->timer);
+
+    /* write pending samples and leave the sampled regions */
+    vt_sample_sync(i, &time, 1);
+
+    if ( s->lost > 0 )
+    {
+      vt_cntl_msg(1, "Dropped %u samples of thread #%u; consider to "
+                     "increase VT_SAMPLE_INTV", s->lost, i);
+    }
+
+    VTThrdv[i]->sample = NULL;
+    free(s);
+  }
+}
+
+void vt_sample_sync(uint32_t tid, uint64_t* time, uint8_t leave)
+{
+  struct vt_sample* s = VTThrdv[tid]->sample;
+  uint32_t ridv[VT_SAMPLE_MAX_DEPTH];
+
+  /* write pending samples */
+  while ( s->tail != s->head )
+  {
+    struct vt_sample_rec* rec = &(s->recv[s->tail % VT_SAMPLE_PENDING]);
+    uint32_t depth = 0;
+    int i;
+
+    /* resolve the call path, outermost function first; the return
+       addresses point behind the calls, so look up the previous byte */
+    for ( i = rec->depth - 1; i >= 0; i-- )
+    {
+      char* addr = (char*)rec->addrv[i];
+      uint32_t rid = gnu_addr2rid((i == 0) ? addr : addr - 1);
+
+      if ( rid != VT_NO_ID )
+        ridv[depth++] = rid;
+    }
+
+    vt_sample_apply(tid, s, &(rec->time), ridv, depth);
+
+    s->tail++;
+  }
+
+  /* leave the sampled regions, if the region below will be left */
+  if ( leave && VTTHRD_STACK_LEVEL(VTThrdv[tid]) == s->top )
+  {
+    vt_sample_apply(tid, s, time, NULL, 0);
+    s->top--;
+  }
+}
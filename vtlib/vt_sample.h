@@ -0,0 +1,31 @@
+/**
+ * VampirTrace
+ * http://www.tu-dresden.de/zih/vampirtrace
+ *
+ * Copyright (c) 2005-2010, ZIH, TU Dresden, Federal Republic of Germany
+ *
+ * Copyright (c) 1998-2005, Forschungszentrum Juelich, Juelich Supercomputing
+ *                          Centre, Federal Republic of Germany
+ *
+ * See the file COPYING in the package base directory for details
+ **/
+
+#ifndef _VT_SAMPLE_H
+#define _VT_SAMPLE_H
+
+#ifdef __cplusplus
+#   define EXTERN extern "C" 
+#else
+#   define EXTERN extern 
+#endif
+
+#include "vt_inttypes.h"
+
+struct vt_sample;
+
+EXTERN void vt_sample_thread_init(uint32_t tid);
+EXTERN void vt_sample_finalize(void);
+
+EXTERN void vt_sample_sync(uint32_t tid, uint64_t* time, uint8_t leave);
+
+#endif /* _VT_SAMPLE_H */
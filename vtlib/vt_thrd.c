@@ -18,6 +18,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "vt_atomic.h"
 #include "vt_thrd.h"
 #include "vt_metric.h"
 #include "vt_pform.h"
@@ -26,14 +27,35 @@
 #include "vt_trc.h"
 #include "vt_iowrap.h"
 
+#if defined(VT_SAMPLE)
+# include "vt_sample.h"
+#endif /* VT_SAMPLE */
+
 
 #if defined(VT_PLUGIN_CNTR)
 # include "vt_plugin_cntr_int.h"
 #endif /* VT_PLUGIN_CNTR */
 
+#if defined(VT_THRD_PTHREAD)
+# include <pthread.h>
+#endif /* VT_THRD_PTHREAD */
+
+
+/* initial number of entries of the vector of the thread objects */
+#define VTTHRD_VEC_INIT_SIZE 64
 
-/* vector of the thread objects */
-VTThrd** VTThrdv = NULL;
+/* vector of the thread objects; volatile, so that each access loads the
+   current vector rather than one cached before it was replaced */
+VTThrd** volatile VTThrdv = NULL;
+
+/* number of entries of VTThrdv */
+static uint32_t VTThrdvSize = 0;
+
+/* replaced vectors of the thread objects; other threads may still read
+   from them, so they are freed not before VTThrd_finalize (as the vector
+   doubles its size, there are at most log2(VT_MAX_THREADS) of them) */
+static VTThrd** VTThrdvOld[32];
+static uint32_t VTThrdvOldNum = 0;
 
 /* number of thread objects */
 uint32_t VTThrdn = 1;
@@ -52,8 +74,11 @@ void VTThrd_init()
   /* get the maximum number of threads */
   VTThrdMaxNum = (uint32_t)vt_env_max_threads();
 
-  /* create vector of the thread objects */
-  VTThrdv = (VTThrd**)calloc(VTThrdMaxNum, sizeof(VTThrd*));
+  /* create vector of the thread objects; it grows, if necessary */
+  VTThrdvSize = VTTHRD_VEC_INIT_SIZE;
+  if ( VTThrdvSize > VTThrdMaxNum && VTThrdMaxNum > 0 )
+    VTThrdvSize = VTThrdMaxNum;
+  VTThrdv = (VTThrd**)calloc(VTThrdvSize, sizeof(VTThrd*));
   if ( VTThrdv == NULL )
     vt_error();
 
@@ -91,26 +116,70 @@ void VTThrd_finalize()
   VTThrd_deleteMutex(&VTThrdMutexIds);
 #endif /* VT_MT || VT_HYB || VT_JAVA */
 
+  /* free vectors of the thread objects */
+  while ( VTThrdvOldNum > 0 )
+    free(VTThrdvOld[--VTThrdvOldNum]);
   if ( VTThrdv != NULL )
     free(VTThrdv);
 }
 
-uint32_t VTThrd_createNewThreadId()
+/* store the thread object of thread-ID tid in VTThrdv, replace the vector
+   by a larger copy, if it's too small */
+static void thrdv_put(uint32_t tid, VTThrd* thread)
 {
-  uint32_t tid;
-
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
   VTTHRD_LOCK_ENV();
 #endif /* VT_MT || VT_HYB || VT_JAVA */
-  if ( VTThrdn > VTThrdMaxNum )
+
+  if ( tid >= VTThrdvSize )
   {
+    VTThrd** oldv = VTThrdv;
+    VTThrd** newv;
+    uint32_t size = VTThrdvSize;
+
+    /* grow by doubling up to the maximum number of threads */
+    while ( size <= tid ) size *= 2;
+    if ( size > VTThrdMaxNum && VTThrdMaxNum > tid ) size = VTThrdMaxNum;
+
+    newv = (VTThrd**)calloc(size, sizeof(VTThrd*));
+    if ( newv == NULL )
+      vt_error();
+    memcpy(newv, oldv, VTThrdvSize * sizeof(VTThrd*));
+
+    vt_assert(VTThrdvOldNum < sizeof(VTThrdvOld) / sizeof(VTThrd**));
+    VTThrdvOld[VTThrdvOldNum++] = oldv;
+
+    /* publish the new vector not before its entries are written, readers
+       which still see the old one find the same entries there */
+#if defined(VT_HAVE_ATOMICS)
+    (void)VT_ATOMIC_CAS(&VTThrdv, oldv, newv);
+#else /* VT_HAVE_ATOMICS */
+    VTThrdv = newv;
+#endif /* VT_HAVE_ATOMICS */
+    VTThrdvSize = size;
+
+    vt_cntl_msg(3, "Vector of the thread objects grown to %u entries", size);
+  }
+
+  VTThrdv[tid] = thread;
+
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-    VTTHRD_UNLOCK_ENV();
+  VTTHRD_UNLOCK_ENV();
 #endif /* VT_MT || VT_HYB || VT_JAVA */
-    vt_error_msg("Cannot create more than %d threads", VTThrdMaxNum);
+}
+
+uint32_t VTThrd_tryNewThreadId()
+{
+  uint32_t tid = VT_NO_ID;
+
+#if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
+  VTTHRD_LOCK_ENV();
+#endif /* VT_MT || VT_HYB || VT_JAVA */
+  if ( VTThrdn < VTThrdMaxNum )
+  {
+    tid = VTThrdn;
+    VTThrdn++;
   }
-  tid = VTThrdn;
-  VTThrdn++;
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
   VTTHRD_UNLOCK_ENV();
 #endif /* VT_MT || VT_HYB || VT_JAVA */
@@ -118,6 +187,16 @@ uint32_t VTThrd_createNewThreadId()
   return tid;
 }
 
+uint32_t VTThrd_createNewThreadId()
+{
+  uint32_t tid = VTThrd_tryNewThreadId();
+
+  if ( tid == VT_NO_ID )
+    vt_error_msg("Cannot create more than %d threads", VTThrdMaxNum);
+
+  return tid;
+}
+
 void VTThrd_create(uint32_t tid, uint32_t ptid, const char* tname, uint8_t is_virtual)
 {
   VTThrd *thread;
@@ -128,9 +207,25 @@ void VTThrd_create(uint32_t tid, uint32_t ptid, const char* tname, uint8_t is_vi
   uint32_t num_rusage = (uint32_t)vt_rusage_num();
 #endif /* VT_RUSAGE */
 
-  thread = (VTThrd*)calloc(1, sizeof(VTThrd));
-  if ( thread == NULL )
-    vt_error();
+  /* allocate thread object aligned to a cache line and padded to whole
+     cache lines, so that the hot fields of different threads never share
+     a cache line; as the object is created by the thread itself (except
+     virtual threads), its memory is first touched on the thread's node */
+  {
+    size_t size = ((sizeof(VTThrd) + VT_CACHE_LINE_SIZE - 1)
+                   / VT_CACHE_LINE_SIZE) * VT_CACHE_LINE_SIZE;
+    size_t misalign;
+    void* mem;
+
+    mem = calloc(1, size + VT_CACHE_LINE_SIZE - 1);
+    if ( mem == NULL )
+      vt_error();
+
+    misalign = (size_t)mem % VT_CACHE_LINE_SIZE;
+    thread = (VTThrd*)((char*)mem +
+               (misalign ? VT_CACHE_LINE_SIZE - misalign : 0));
+    thread->mem = mem;
+  }
 
   /* set thread name, if available */
   if ( tname == NULL )
@@ -215,7 +310,7 @@ void VTThrd_create(uint32_t tid, uint32_t ptid, const char* tname, uint8_t is_vi
   /* enable tracing */
   thread->trace_status = VT_TRACE_ON;
 
-  VTThrdv[tid] = thread;
+  thrdv_put(tid, thread);
 
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
   VTTHRD_LOCK_ENV();
@@ -269,6 +364,11 @@ void VTThrd_open(uint32_t tid)
   }
 #endif /* VT_IOWRAP */
 
+#if defined(VT_SAMPLE)
+  /* start sampling of this thread, if enabled */
+  vt_sample_thread_init(tid);
+#endif /* VT_SAMPLE */
+
 #if defined(VT_PLUGIN_CNTR)
   /* if we really use plugins */
   if ( vt_plugin_cntr_used && tid != 0 )
@@ -295,14 +395,102 @@ void VTThrd_close(VTThrd* thrd)
   if ( !thrd ) return;
 
 #if defined(VT_PLUGIN_CNTR)
-  /* TODO: add post mortem asynch plugins get result at later release */
+  /* dummy threads of plugin counters are closed by their owners */
+  if ( thrd->plugin_cntr_dummy ) return;
+
   /* if we really use plugins and this thread also uses some */
   if ( vt_plugin_cntr_used&&(thrd->plugin_cntr_defines) )
+  {
+    VTThrd* dummy;
+
+    vt_plugin_cntr_write_callback_data(thrd, 1);
     vt_plugin_cntr_final_write_post_mortem(thrd);
+
+    /* close the dummy thread after its last values are written, so
+       thread objects can be closed concurrently */
+    if ( (dummy = vt_plugin_cntr_get_dummy_thread(thrd)) != NULL )
+      VTGen_close(dummy->gen);
+  }
 #endif /* VT_PLUGIN_CNTR */
   VTGen_close(thrd->gen);
 }
 
+#if defined(VT_THRD_PTHREAD)
+
+/* thread objects to be closed by the closing threads */
+static pthread_mutex_t closeMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t closeNext = 0;
+static uint32_t closeNum = 0;
+
+static void* VTThrd_closeWorker(void* arg)
+{
+  uint32_t tid;
+
+  (void)arg;
+
+  for(;;)
+  {
+    /* get next thread object */
+    pthread_mutex_lock(&closeMutex);
+    tid = closeNext++;
+    pthread_mutex_unlock(&closeMutex);
+
+    if ( tid >= closeNum ) break;
+
+    VTThrd_close(VTThrdv[tid]);
+  }
+
+  return NULL;
+}
+
+#endif /* VT_THRD_PTHREAD */
+
+void VTThrd_closeAll(uint32_t tnum)
+{
+  uint32_t i;
+
+#if defined(VT_THRD_PTHREAD)
+  /* close the thread objects by several threads, in order to overlap
+     the final flushes (incl. compression) of their trace files */
+  uint32_t nworkers = (uint32_t)vt_env_close_threads();
+
+  if ( nworkers > tnum ) nworkers = tnum;
+
+  if ( nworkers > 1 )
+  {
+    pthread_t* workers;
+    uint32_t n;
+
+    workers = (pthread_t*)malloc((nworkers - 1) * sizeof(pthread_t));
+    if ( workers == NULL )
+      vt_error();
+
+    closeNext = 0;
+    closeNum = tnum;
+
+    /* the calling thread is one of the closing threads */
+    for ( n = 0; n < nworkers - 1; n++ )
+    {
+      if ( pthread_create(&workers[n], NULL, VTThrd_closeWorker, NULL) != 0 )
+        break;
+    }
+    VTThrd_closeWorker(NULL);
+
+    for ( i = 0; i < n; i++ )
+      pthread_join(workers[i], NULL);
+
+    free(workers);
+
+    vt_cntl_msg(2, "Closed %u thread objects by %u threads", tnum, n + 1);
+
+    return;
+  }
+#endif /* VT_THRD_PTHREAD */
+
+  for ( i = 0; i < tnum; i++ )
+    VTThrd_close(VTThrdv[i]);
+}
+
 void VTThrd_delete(VTThrd* thrd, uint32_t tid)
 {
   if ( !thrd ) return;
@@ -349,6 +537,11 @@ void VTThrd_delete(VTThrd* thrd, uint32_t tid)
       free(thrd->valv);
       thrd->valv = NULL;
     }
+    if ( thrd->met_lastv )
+    {
+      free(thrd->met_lastv);
+      thrd->met_lastv = NULL;
+    }
   }
 #endif /* VT_METR */
 
@@ -358,7 +551,7 @@ void VTThrd_delete(VTThrd* thrd, uint32_t tid)
     vt_plugin_cntr_thread_exit(thrd);
 #endif /* VT_PLUGIN_CNTR */
 
-  free(thrd);
+  free(thrd->mem);
 
   /* decrement the thread object counter */
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
@@ -414,10 +607,15 @@ void VTThrd_destroy(VTThrd* thrd, uint32_t tid)
       free(thrd->valv);
       thrd->valv = NULL;
     }
+    if ( thrd->met_lastv )
+    {
+      free(thrd->met_lastv);
+      thrd->met_lastv = NULL;
+    }
   }
 #endif /* VT_METR */
 
-  free(thrd);
+  free(thrd->mem);
 
   /* decrement the thread object counter */
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
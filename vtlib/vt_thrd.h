@@ -25,6 +25,7 @@
 #include "vt_error.h"
 #include "vt_inttypes.h"
 #include "vt_otf_gen.h"
+#include "vt_ovhd.h"
 
 #if defined(VT_JAVA)
 # include "vt_java.h"
@@ -34,10 +35,26 @@
 # include "vt_rusage.h"
 #endif /* VT_RUSAGE */
 
+#if defined(VT_SAMPLE)
+# include "vt_sample.h"
+#endif /* VT_SAMPLE */
+
 
 #include "rfg.h"
 
-#if (defined(VT_MT) || defined(VT_HYB))
+#if (defined(VT_MT) || defined(VT_HYB)) && defined(VT_THRD_PTHREAD) && \
+    defined(HAVE_TLS)
+  /* take the thread-ID from thread-local storage, if the thread is already
+     registered; otherwise (or after the thread terminated), fall back to
+     the thread-specific data */
+# define VT_THRD_TLS_ID
+# define VT_MY_THREAD_IS_ALIVE \
+  (VTThrdTlsId != 0 || VTThrd_is_alive())
+# define VT_MY_THREAD \
+  (VTThrdTlsId != 0 ? VTThrdTlsId - 1 : VTThrd_getThreadId())
+# define VT_CHECK_THREAD \
+  (VTThrdTlsId != 0 ? (void)0 : VTThrd_registerThread(0))
+#elif (defined(VT_MT) || defined(VT_HYB))
 # define VT_MY_THREAD_IS_ALIVE VTThrd_is_alive()
 # define VT_MY_THREAD          VTThrd_getThreadId()
 # define VT_CHECK_THREAD       VTThrd_registerThread(0)
@@ -53,42 +70,73 @@
 
 
 
-/** Maximum number of threads to be created */
+/** Maximum number of threads to be created (VTThrdv grows on demand up to
+    this number of entries) */
 EXTERN uint32_t VTThrdMaxNum;
 
+#if defined(VT_THRD_TLS_ID)
+/** Thread-ID + 1 of the current thread (0 = not registered) */
+EXTERN __thread uint32_t VTThrdTlsId;
+#endif /* VT_THRD_TLS_ID */
+
 /** VTThrd struct holds all thread-specific data:
  * - Trace buffer and file including file name
  * - Event sets and value vector
  * - ...
+ *
+ * The fields accessed at each event come first, so they share the first
+ * cache line of the structure; the thread objects are aligned to cache
+ * lines and don't share a cache line with each other (see VTThrd_create).
  *-----------------------------------------------------------------------------
  */
 typedef struct
 {
+  /* -- hot fields -- */
+
   VTGen* gen;                     /**< trace file and buffer */
 
-  char  name[512];                /**< thread name */
-  char  name_suffix[128];         /**< suffix of thread name */
+#if !defined(VT_DISABLE_RFG)
+
+  RFG_Regions* rfg_regions;
+
+#endif /* VT_DISABLE_RFG */
 
   int stack_level;                /**< current call stack level */
-  int stack_level_at_off;         /**< call stack level at trace off */
-  int stack_level_at_rewind_mark; /**< call stack level at rewind mark */
 
   int8_t trace_status;            /**< trace status:
                                      VT_TRACE_ON,
                                      VT_TRACE_OFF, or
                                      VT_TRACE_OFF_PERMANENT */
 
+  uint8_t is_virtual_thread;      /**< flag: virtual thread? */
+
+  /* -- cold fields -- */
+
+  void* mem;                      /**< allocated memory of the object */
+
+  uint64_t ovhd_time[VT_OVHD_NUM];  /**< accounted tracer overhead (ticks) */
+  uint64_t ovhd_calls[VT_OVHD_NUM]; /**< number of accounted sections */
+#if (defined (VT_MPI) || defined (VT_HYB))
+  uint64_t ovhd_mpiwrap_time;     /**< begin of the accounted MPI wrapper
+                                     section (0 = none) */
+#endif /* VT_MPI || VT_HYB */
+
+  int stack_level_at_off;         /**< call stack level at trace off */
+  int stack_level_at_rewind_mark; /**< call stack level at rewind mark */
+
   uint32_t parent_tid;            /**< parent thread id */
   uint32_t child_num;             /**< number of child threads */
 
+  uint32_t id_next;               /**< next free id of the thread's id block */
+  uint32_t id_end;                /**< end of the thread's id block */
 
-  uint8_t is_virtual_thread;      /**< flag: virtual thread? */
-
-#if !defined(VT_DISABLE_RFG)
+#if defined(VT_THRD_PTHREAD)
 
-  RFG_Regions* rfg_regions;
+  volatile uint32_t idle_tids;    /**< head of the list of idle thread ids
+                                     of the child threads (VT_PTHREAD_REUSE) */
+  uint32_t idle_next;             /**< next entry, if the thread is idle */
 
-#endif /* VT_DISABLE_RFG */
+#endif /* VT_THRD_PTHREAD */
 
 #if (defined (VT_MPI) || defined (VT_HYB))
 
@@ -125,11 +173,23 @@ typedef struct
 
 #endif /* VT_RUSAGE */
 
+#if defined(VT_SAMPLE)
+
+  struct vt_sample* sample;       /**< sampler state */
+
+#endif /* VT_SAMPLE */
+
 #if defined(VT_METR)
 
   uint64_t*       offv;           /**< vector of counter offsets */
   uint64_t*       valv;           /**< vector of counter values */
   struct vt_metv* metv;           /**< vector of metric objects (i.e.the event set) */
+  uint64_t*       met_lastv;      /**< vector of last written counter values
+                                     (VT_METRICS_THRESHOLD) */
+  uint64_t        met_next_read;  /**< next timestamp for reading counters
+                                     (VT_METRICS_INTV) */
+  uint32_t        met_events;     /**< events since last reading counters
+                                     (VT_METRICS_EVENTS) */
 
 #endif /* VT_METR */
 
@@ -137,9 +197,14 @@ typedef struct
 #if defined(VT_PLUGIN_CNTR)
 
   void*   plugin_cntr_defines;    /**< plugin cntr handle */
+  uint8_t plugin_cntr_dummy;      /**< flag: dummy thread of the
+                                       asynchronous plugin counters? */
 
 #endif /* VT_PLUGIN_CNTR || VT_CUDARTWRAP */
 
+  char  name[512];                /**< thread name */
+  char  name_suffix[128];         /**< suffix of thread name */
+
 } VTThrd;
 
 /* Accessor macros */
@@ -229,6 +294,13 @@ typedef struct
 
 #endif /* VT_RUSAGE */
 
+#if (defined (VT_SAMPLE))
+
+/* sampler state */
+#define VTTHRD_SAMPLE(thrd)              (thrd->sample)
+
+#endif /* VT_SAMPLE */
+
 #if (defined (VT_METR))
 
 /* vector of metric offsets */
@@ -240,6 +312,15 @@ typedef struct
 /* vector of metric objects (i.e., event sets) */
 #define VTTHRD_METV(thrd)                (thrd->metv)
 
+/* last written metric values (VT_METRICS_THRESHOLD) */
+#define VTTHRD_MET_LASTV(thrd)           (thrd->met_lastv)
+
+/* next timestamp for reading metrics (VT_METRICS_INTV) */
+#define VTTHRD_MET_NEXT_READ(thrd)       (thrd->met_next_read)
+
+/* number of events since reading metrics (VT_METRICS_EVENTS) */
+#define VTTHRD_MET_EVENTS(thrd)          (thrd->met_events)
+
 #endif /* VT_METR */
 
 #if defined(VT_PLUGIN_CNTR)
@@ -267,6 +348,14 @@ EXTERN void     VTThrd_finalize( void );
  */
 EXTERN uint32_t VTThrd_createNewThreadId( void );
 
+/**
+ * Increments the global thread counter and returns a new valid thread id,
+ * unless the maximum number of threads is reached.
+ *
+ * @return the requested thread id or VT_NO_ID
+ */
+EXTERN uint32_t VTThrd_tryNewThreadId( void );
+
 /**
  * Creates a thread object.
  *
@@ -307,11 +396,21 @@ EXTERN void     VTThrd_open( uint32_t tid );
  */
 EXTERN void     VTThrd_close( VTThrd* thrd );
 
+/**
+ * Close the associated trace files of all threads.
+ *
+ * @param tnum number of thread objects
+ */
+EXTERN void     VTThrd_closeAll( uint32_t tnum );
+
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
 
 /* macros for (un)locking predefined mutexes */
 #define VTTHRD_LOCK_ENV() VTThrd_lock(&VTThrdMutexEnv)
 #define VTTHRD_UNLOCK_ENV() VTThrd_unlock(&VTThrdMutexEnv)
+/* the ids mutex guards the first definition of a region (shared RFG
+   region table, region group and source file hash tables) and of
+   VampirTrace's own markers; identifiers alone don't need it */
 #define VTTHRD_LOCK_IDS() VTThrd_lock(&VTThrdMutexIds)
 #define VTTHRD_UNLOCK_IDS() VTThrd_unlock(&VTThrdMutexIds)
 
@@ -375,8 +474,10 @@ EXTERN VTThrdMutex* VTThrdMutexIds;  /* ... VT IDs */
 
 #endif /* VT_MT || VT_HYB || VT_JAVA */
 
-/** vector of the thread objects */
-EXTERN VTThrd** VTThrdv;
+/** vector of the thread objects; it may be replaced by a larger copy when
+    a thread is created, but the replaced vectors stay valid until
+    VTThrd_finalize, so it can be read without locking */
+EXTERN VTThrd** volatile VTThrdv;
 
 /** number of thread objects */
 EXTERN uint32_t VTThrdn;
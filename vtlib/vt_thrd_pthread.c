@@ -10,11 +10,14 @@
  * See the file COPYING in the package base directory for details
  **/
 
+#include "config.h"
+
 #include <stdlib.h>
 #include <string.h>
 
 #include <pthread.h>
 
+#include "vt_atomic.h"
 #include "vt_env.h"
 #include "vt_error.h"
 #include "vt_inttypes.h"
@@ -33,87 +36,96 @@ struct VTThrdMutex_struct
   pthread_mutex_t m;
 };
 
-/* data structure for list of idle thread-IDs */
-typedef struct IdleThreadIdListEntryS
-{
-  uint32_t tid;
-  struct IdleThreadIdListEntryS* next;
-} IdleThreadIdListEntryT;
-
-/* data structure that holds the list of idle thread-IDs per thread */
-typedef struct IdleThreadIdListS
-{
-  IdleThreadIdListEntryT* first;
-  IdleThreadIdListEntryT* last;
-  uint32_t size;
-} IdleThreadIdListT;
+/* The idle thread-IDs of the child threads of a thread form a LIFO list,
+   which is linked through the thread objects of the idle threads
+   (VTThrd.idle_next). The list head (VTThrd.idle_tids) holds the first
+   thread-ID in its lower 16 bits (thread-IDs are less than VT_MAX_THREADS;
+   0 means empty, as the master thread is never reused) and a counter of
+   modifications in its upper 16 bits, so that a compare-and-swap fails,
+   if the same thread-ID was popped and pushed again meanwhile (ABA). */
+#define IDLE_TID(head)         ((head) & 0xffff)
+#define IDLE_HEAD(head, tid)   ((((head) & 0xffff0000) + 0x10000) | (tid))
+
+#if defined(VT_HAVE_ATOMICS)
+# define IDLE_TIDS_LOCK()
+# define IDLE_TIDS_UNLOCK()
+# define IDLE_TIDS_CAS(ptr, oldval, newval) \
+  VT_ATOMIC_CAS(ptr, oldval, newval)
+#else /* VT_HAVE_ATOMICS */
+# define IDLE_TIDS_LOCK()   pthread_mutex_lock(&threadReuseMutex)
+# define IDLE_TIDS_UNLOCK() pthread_mutex_unlock(&threadReuseMutex)
+# define IDLE_TIDS_CAS(ptr, oldval, newval) \
+  ((*(ptr) == (oldval)) ? (*(ptr) = (newval), 1) : 0)
+#endif /* VT_HAVE_ATOMICS */
 
 static pthread_key_t pthreadKey;
 
+#if defined(VT_THRD_TLS_ID)
+/* thread-ID + 1 of the current thread; the thread-specific data above is
+   still needed for its destructor, but lookups go to this variable */
+__thread uint32_t VTThrdTlsId = 0;
+#endif /* VT_THRD_TLS_ID */
+
+#if !defined(VT_HAVE_ATOMICS)
 static pthread_mutex_t threadReuseMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif /* VT_HAVE_ATOMICS */
 static pthread_mutex_t mutexInitMutex = PTHREAD_MUTEX_INITIALIZER;
 
-static IdleThreadIdListT* idleThreadIds = NULL;
-
 static uint8_t  reuseThreadIds = 0;
 static uint8_t  masterThreadTerminated = 0;
 
-static uint32_t idle_tid_list_size(uint32_t ptid)
-{
-  vt_assert(ptid < VTThrdMaxNum);
-  return idleThreadIds[ptid].size;
-}
-
-static void idle_tid_list_push_back(uint32_t ptid, uint32_t tid)
+static void idle_tid_list_push(uint32_t ptid, uint32_t tid)
 {
-  IdleThreadIdListEntryT* idle_tid;
+  VTThrd* parent = VTThrdv[ptid];
+  uint32_t head;
 
-  vt_assert(ptid < VTThrdMaxNum);
+  vt_assert(tid > 0 && tid <= 0xffff);
 
-  /* create new list entry */
-  idle_tid = (IdleThreadIdListEntryT*)calloc(1,
-               sizeof(IdleThreadIdListEntryT));
-  if (idle_tid == NULL)
-    vt_error();
-
-  idle_tid->tid = tid;
-
-  /* append new entry to list */
-  if (idleThreadIds[ptid].last)
-  {
-    idleThreadIds[ptid].last->next = idle_tid;
-    idleThreadIds[ptid].last = idle_tid;
-  }
-  else
+  IDLE_TIDS_LOCK();
+  do
   {
-    idleThreadIds[ptid].first = idleThreadIds[ptid].last = idle_tid;
-  }
-
-  /* increment size of list */
-  idleThreadIds[ptid].size++;
+    head = parent->idle_tids;
+    VTThrdv[tid]->idle_next = IDLE_TID(head);
+  } while (!IDLE_TIDS_CAS(&(parent->idle_tids), head, IDLE_HEAD(head, tid)));
+  IDLE_TIDS_UNLOCK();
 }
 
-static uint32_t idle_tid_list_pop_front(uint32_t ptid)
+/* returns 0, if there is no idle thread-ID */
+static uint32_t idle_tid_list_pop(uint32_t ptid)
 {
+  VTThrd* parent = VTThrdv[ptid];
+  uint32_t head;
   uint32_t tid;
-  IdleThreadIdListEntryT* tmp;
 
-  vt_assert(ptid < VTThrdMaxNum);
-  vt_assert(idleThreadIds[ptid].size > 0);
+  IDLE_TIDS_LOCK();
+  do
+  {
+    head = parent->idle_tids;
+    tid = IDLE_TID(head);
+    if (tid == 0) break;
 
-  /* get thread-ID from the first list entry */
-  tid = idleThreadIds[ptid].first->tid;
+    /* the thread object of an idle thread-ID is never freed before
+       vt_close, so reading its link is safe even if another thread
+       popped it meanwhile; the compare-and-swap fails then */
+  } while (!IDLE_TIDS_CAS(&(parent->idle_tids), head,
+                          IDLE_HEAD(head, VTThrdv[tid]->idle_next)));
+  IDLE_TIDS_UNLOCK();
 
-  /* remove first list entry */
-  tmp = idleThreadIds[ptid].first;
-  if (idleThreadIds[ptid].first == idleThreadIds[ptid].last)
-    idleThreadIds[ptid].first = idleThreadIds[ptid].last = NULL;
-  else
-    idleThreadIds[ptid].first = tmp->next;
-  free(tmp);
+  return tid;
+}
 
-  /* decrement size of list */
-  idleThreadIds[ptid].size--;
+/* takes an idle thread-ID of any parent; returns 0, if there is none */
+static uint32_t idle_tid_list_pop_any(void)
+{
+  uint32_t n = VTThrdn;
+  uint32_t ptid;
+  uint32_t tid = 0;
+
+  for (ptid = 0; ptid < n && tid == 0; ptid++)
+  {
+    if (VTThrdv[ptid] != NULL)
+      tid = idle_tid_list_pop(ptid);
+  }
 
   return tid;
 }
@@ -122,6 +134,11 @@ static void pthread_key_destructor(void* data)
 {
   uint32_t tid = *((uint32_t*)data);
 
+#if defined(VT_THRD_TLS_ID)
+  /* the thread-ID may be handed over to another thread from now on */
+  VTThrdTlsId = 0;
+#endif /* VT_THRD_TLS_ID */
+
 #if defined(VT_METR)
   if (vt_is_alive && vt_metric_num() > 0 && VTThrdv[tid]->metv)
   {
@@ -136,16 +153,9 @@ static void pthread_key_destructor(void* data)
     /* register termination of main() thread (*tid==0) */
     masterThreadTerminated = 1;
 
-    /* TODO: It's unclear whether/where the lists of idle thread-IDs should
-             be freed. Maybe at this point? */
   }
-  else if (vt_is_alive && reuseThreadIds)
+  else if (vt_is_alive)
   {
-    /* store thread-ID for reuse */
-    pthread_mutex_lock(&threadReuseMutex);
-    idle_tid_list_push_back(VTThrdv[tid]->parent_tid, tid);
-    pthread_mutex_unlock(&threadReuseMutex);
-
     /* store last metric values */
 #if defined(VT_METR)
     if (vt_metric_num() > 0 && VTThrdv[tid]->offv && VTThrdv[tid]->valv)
@@ -159,6 +169,11 @@ static void pthread_key_destructor(void* data)
     if (vt_plugin_cntr_used && VTThrdv[tid]->plugin_cntr_defines)
       vt_plugin_cntr_thread_disable_counters(VTThrdv[tid]);
 #endif /* VT_PLUGIN_CNTR */
+
+    /* store thread-ID for reuse (without VT_PTHREAD_REUSE only when no
+       new thread-IDs are left); from now on, another thread may take
+       over the thread object */
+    idle_tid_list_push(VTThrdv[tid]->parent_tid, tid);
   }
 
   /* free thread-specific data */
@@ -175,14 +190,7 @@ void VTThrd_initPthread()
     initflag = 0;
 
     /* reuse thread IDs of terminated threads? */
-    if ((reuseThreadIds = (uint8_t)vt_env_pthread_reuse()))
-    {
-      /* create lists for idle thread-IDs */
-      idleThreadIds = (IdleThreadIdListT*)calloc(VTThrdMaxNum,
-                        sizeof(IdleThreadIdListT));
-      if (idleThreadIds == NULL)
-        vt_error();
-    }
+    reuseThreadIds = (uint8_t)vt_env_pthread_reuse();
 
     /* create thread-specific data key for all threads */
     if (pthread_key_create(&pthreadKey, pthread_key_destructor) != 0)
@@ -197,6 +205,10 @@ void VTThrd_initPthread()
     if (pthread_setspecific(pthreadKey, master_tid) != 0)
       vt_error();
 
+#if defined(VT_THRD_TLS_ID)
+    VTThrdTlsId = 1;
+#endif /* VT_THRD_TLS_ID */
+
 #if defined(VT_METR)
     if (vt_metric_num() > 0)
       vt_metric_thread_init((long (*)(void))(pthread_self));
@@ -221,21 +233,35 @@ void VTThrd_registerThread(uint32_t ptid)
     /* try to get idle thread-ID for reuse, if desired */
     if (reuseThreadIds)
     {
-      pthread_mutex_lock(&threadReuseMutex);
-      if (idle_tid_list_size(ptid) > 0)
+      *tid = idle_tid_list_pop(ptid);
+      tid_reuse = (*tid != 0);
+    }
+
+    if (!tid_reuse)
+    {
+      *tid = VTThrd_tryNewThreadId();
+
+      /* all thread-IDs are taken; rather than aborting, take over the
+         thread-ID of a terminated thread, even of another parent */
+      if (*tid == VT_NO_ID)
       {
-        *tid = idle_tid_list_pop_front(ptid);
-        tid_reuse = 1;
+        *tid = idle_tid_list_pop_any();
+        tid_reuse = (*tid != 0);
+        if (!tid_reuse)
+          vt_error_msg("Cannot create more than %d threads", VTThrdMaxNum);
+        vt_cntl_msg(2, "Maximum number of threads reached, "
+                       "reusing ID of terminated thread #%d", *tid);
       }
-      pthread_mutex_unlock(&threadReuseMutex);
     }
 
-    if (!tid_reuse) *tid = VTThrd_createNewThreadId();
-
     /* put (new) thread-ID to thread-specific data
        no IO before this call (fflush calls this function) */
     pthread_setspecific(pthreadKey, tid);
 
+#if defined(VT_THRD_TLS_ID)
+    VTThrdTlsId = *tid + 1;
+#endif /* VT_THRD_TLS_ID */
+
     /* create new thread object, if new thread-ID was created */
     if (!tid_reuse){
       vt_cntl_msg(2, "Dynamic thread creation. Thread #%d", *tid);
@@ -280,6 +306,11 @@ uint32_t VTThrd_getThreadId()
 {
   uint32_t *tid;
 
+#if defined(VT_THRD_TLS_ID)
+  if (VTThrdTlsId != 0)
+    return VTThrdTlsId - 1;
+#endif /* VT_THRD_TLS_ID */
+
   /* get thread-ID from thread-specific data */
   tid = (uint32_t*)pthread_getspecific(pthreadKey);
 
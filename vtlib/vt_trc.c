@@ -29,6 +29,8 @@
 #include "vt_thrd.h"
 #include "vt_trc.h"
 #include "vt_otf_gen.h"
+#include "vt_ovhd.h"
+#include "vt_atomic.h"
 #include "vt_env.h"
 #include "vt_fork.h"
 #include "vt_iowrap.h"
@@ -38,7 +40,7 @@
 #include "vt_pform.h"
 #include "vt_error.h"
 
-#include "util/hash.h"
+#include "util/htab.h"
 #include "util/installdirs.h"
 
 #if defined(VT_LIBWRAP)
@@ -74,6 +76,10 @@
 # include "vt_rusage.h"
 #endif /* VT_RUSAGE */
 
+#if defined(VT_SAMPLE)
+# include "vt_sample.h"
+#endif /* VT_SAMPLE */
+
 #if defined(VT_PLUGIN_CNTR)
 # include "vt_plugin_cntr_int.h"
 #endif /* VT_PLUGIN_CNTR */
@@ -85,103 +91,47 @@
     (tid) = VT_MY_THREAD;             \
   }
 
+/* number of identifiers which a thread takes at once */
+#define VT_ID_BLOCK_SIZE 64
+
+/* maximum number of counter values in a vector counter record */
+#define VT_CNTR_BATCH_SIZE 64
+
 /*
  *-----------------------------------------------------------------------------
- * Two simple hash tables 1: maps region groups to region group identifier
- *                        2: maps file name to file identifier
+ * Two hash tables 1: maps region groups to region group identifier
+ *                 2: maps file name to file identifier
  *-----------------------------------------------------------------------------
  */
 
 #define HASH_TAB__RDESC  0
 #define HASH_TAB__SFILE  1
-#define HASH_MAX 1021
 
-typedef struct HN_rdesc
-{
-  char*             rdesc;  /* region group name */
-  uint32_t          rdid;   /* associated region group identifier */
-  struct HN_rdesc*  next;
-} HashNode_rdesc;
+static VTHtab* htab[2] = { NULL, NULL };
 
-typedef struct HN_sfile
+static void hash_put(int t, const char* n, uint32_t i)
 {
-  char*             fname;  /* source file name */
-  uint32_t          fid;    /* associated source file identifier */
-  struct HN_sfile*  next;
-} HashNode_sfile;
-
-static HashNode_rdesc* htab_rdesc[HASH_MAX];
-static HashNode_sfile* htab_sfile[HASH_MAX];
+  if (htab[t] == NULL)
+    htab[t] = vt_htab_create(VT_HTAB_KEY_STR, 0, sizeof(uint32_t));
 
-static void hash_put(int t, const char* n, int i)
-{
-  uint32_t id = (uint32_t)vt_hash((uint8_t*)n, strlen(n), 0) % HASH_MAX;
-  if(t==HASH_TAB__RDESC)
-  {
-    HashNode_rdesc *add = (HashNode_rdesc*)malloc(sizeof(HashNode_rdesc));
-    add->rdesc = strdup(n);
-    add->rdid = i;
-    add->next = htab_rdesc[id];
-    htab_rdesc[id] = add;
-  }
-  else if(t==HASH_TAB__SFILE)
-  {
-    HashNode_sfile *add = (HashNode_sfile*)malloc(sizeof(HashNode_sfile));
-    add->fname = strdup(n);
-    add->fid = i;
-    add->next = htab_sfile[id];
-    htab_sfile[id] = add;
-  }
+  *(uint32_t*)vt_htab_put(htab[t], n, NULL) = i;
 }
 
-static void* hash_get(int t, const char* n)
+static uint32_t* hash_get(int t, const char* n)
 {
-  uint32_t id = (uint32_t)vt_hash((uint8_t*)n, strlen(n), 0) % HASH_MAX;
-  if(t==HASH_TAB__RDESC)
-  {
-    HashNode_rdesc *curr = htab_rdesc[id];
-    while ( curr ) {
-      if ( strcmp( curr->rdesc, n ) == 0 )
-        return curr;
+  if (htab[t] == NULL) return NULL;
 
-      curr = curr->next;
-    }
-  }
-  else if(t==HASH_TAB__SFILE)
-  {
-    HashNode_sfile *curr = htab_sfile[id];
-    while ( curr ) {
-      if ( strcmp( curr->fname, n ) == 0 )
-        return curr;
-
-      curr = curr->next;
-    }
-  }
-  return NULL;
+  return (uint32_t*)vt_htab_get(htab[t], n);
 }
 
 static void hash_clear(void)
 {
-  int i;
-  HashNode_rdesc* tmp_rdesc;
-  HashNode_sfile* tmp_sfile;
+  int t;
 
-  for ( i = 0; i < HASH_MAX; i++ )
+  for (t = 0; t < 2; t++)
   {
-    while( htab_rdesc[i] )
-    {
-      tmp_rdesc = htab_rdesc[i]->next;
-      free( htab_rdesc[i]->rdesc );
-      free( htab_rdesc[i] );
-      htab_rdesc[i] = tmp_rdesc;
-    }
-    while( htab_sfile[i] )
-    {
-      tmp_sfile = htab_sfile[i]->next;
-      free( htab_sfile[i]->fname );
-      free( htab_sfile[i] );
-      htab_sfile[i] = tmp_sfile;
-    }
+    vt_htab_free(htab[t]);
+    htab[t] = NULL;
   }
 }
 
@@ -243,6 +193,15 @@ static int max_stack_depth = 0;
 #if defined(VT_METR)
   /* number of performance metrics */
   static int num_metrics = 0;
+
+  /* minimum number of events and time (ticks) between two readings of the
+     performance metrics (VT_METRICS_EVENTS, VT_METRICS_INTV) */
+  static uint32_t metric_events = 1;
+  static uint64_t metric_intv = 0;
+
+  /* vector of minimum changes of the metric values to be written
+     (VT_METRICS_THRESHOLD); NULL, if each value is written */
+  static uint64_t* metric_threshv = NULL;
 #endif
 
 #if defined(VT_RUSAGE)
@@ -255,7 +214,9 @@ static int max_stack_depth = 0;
   static VTThrdMutex* init_mutex = NULL;
 #endif /* VT_MT || VT_HYB */
 
-/* id counter starting with 1 */
+/* id counter starting with 1; the threads take their identifiers from
+   private blocks of VT_ID_BLOCK_SIZE ids, which are fetched from this
+   counter (see get_id()) */
 static uint32_t curid = 1;
 
 /* flags: indicate whether vt_open/vt_close called */
@@ -350,6 +311,52 @@ static uint32_t get_unique_file_id(void)
   return new_fuid;
 }
 
+#if defined(VT_METR)
+
+/* set up the policies for reading and writing the performance metrics
+   (VT_METRICS_EVENTS, VT_METRICS_INTV, VT_METRICS_THRESHOLD) */
+static void metric_policy_init(void)
+{
+  char* env = vt_env_metrics_threshold();
+
+  metric_events = (uint32_t)vt_env_metrics_events();
+  metric_intv = (vt_pform_clockres() * (uint64_t)vt_env_metrics_intv()) /
+                1000000;
+
+  if ( env != NULL )
+  {
+    char* var = strdup(env);
+    char* token;
+    int n = 0;
+
+    if ( var == NULL )
+      vt_error();
+
+    metric_threshv = (uint64_t*)calloc(num_metrics, sizeof(uint64_t));
+    if ( metric_threshv == NULL )
+      vt_error();
+
+    /* read a threshold for each metric; a single one applies to all */
+    token = strtok(var, vt_env_metrics_sep());
+    while ( token != NULL )
+    {
+      if ( n == num_metrics || atoll(token) < 0 )
+        vt_error_msg("VT_METRICS_THRESHOLD not properly set");
+      metric_threshv[n++] = (uint64_t)atoll(token);
+      token = strtok(NULL, vt_env_metrics_sep());
+    }
+
+    if ( n == 1 )
+      while ( n < num_metrics ) { metric_threshv[n] = metric_threshv[0]; n++; }
+    else if ( n != num_metrics )
+      vt_error_msg("VT_METRICS_THRESHOLD not properly set");
+
+    free(var);
+  }
+}
+
+#endif /* VT_METR */
+
 static void write_def_header(void)
 {
   int32_t  tmp_int32;
@@ -402,6 +409,42 @@ static void write_def_header(void)
   vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_BUFFER_SIZE: %s",
                  tmp_char);
 
+  /* VT_BUFFER_PACKED */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_BUFFER_PACKED: %s",
+                 vt_env_buffer_packed() ? "yes" : "no");
+
+  /* VT_FLIGHT_RECORDER */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_FLIGHT_RECORDER: %s",
+                 vt_env_flight_recorder() ? "yes" : "no");
+
+  /* VT_RAW_SPILL */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_RAW_SPILL: %s",
+                 vt_env_raw_spill() ? "yes" : "no");
+
+  /* VT_BUFFER_POOL */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_BUFFER_POOL: %s",
+                 vt_env_buffer_pool() ? "yes" : "no");
+
+  /* VT_MIN_DURATION */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_MIN_DURATION: %i",
+                 vt_env_min_duration());
+
+  /* VT_OVERHEAD */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_OVERHEAD: %s",
+                 vt_env_overhead() ? "yes" : "no");
+
+  /* VT_STAT_CALLPATH_DEPTH */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_STAT_CALLPATH_DEPTH: %i",
+                 vt_env_stat_callpath_depth());
+
+  /* VT_STAT_CALLPATH_NODES */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_STAT_CALLPATH_NODES: %i",
+                 vt_env_stat_callpath_nodes());
+
+  /* VT_STAT_FUNC_HIST */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_STAT_FUNC_HIST: %s",
+                 vt_env_stat_func_hist() ? "yes" : "no");
+
   /* VT_SYNC_FLUSH */
   vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_SYNC_FLUSH: %s",
                  vt_env_sync_flush() ? "yes" : "no");
@@ -410,6 +453,12 @@ static void write_def_header(void)
   vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_SYNC_FLUSH_LEVEL: %i",
                  vt_env_sync_flush_level());
 
+#if defined(VT_THRD_PTHREAD)
+  /* VT_ASYNC_FLUSH */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_ASYNC_FLUSH: %s",
+                 vt_env_async_flush() ? "yes" : "no");
+#endif /* VT_THRD_PTHREAD */
+
   /* VT_MAX_FLUSHES */
   vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_MAX_FLUSHES: %i", vt_env_max_flushes());
 
@@ -417,6 +466,19 @@ static void write_def_header(void)
   /* VT_METRICS */
   vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_METRICS: %s",
                  vt_env_metrics() ? vt_env_metrics() : "<not set>");
+
+  /* VT_METRICS_INTV */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_METRICS_INTV: %i",
+                 vt_env_metrics_intv());
+
+  /* VT_METRICS_EVENTS */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_METRICS_EVENTS: %i",
+                 vt_env_metrics_events());
+
+  /* VT_METRICS_THRESHOLD */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_METRICS_THRESHOLD: %s",
+                 vt_env_metrics_threshold() ? vt_env_metrics_threshold() :
+                                              "<not set>");
 #endif /* VT_METR */
 
 #if defined(VT_RUSAGE)
@@ -460,6 +522,12 @@ static void write_def_header(void)
                  vt_env_cpuidtrace() ? "yes" : "no");
 #endif /* VT_GETCPU */
 
+#if defined(VT_SAMPLE)
+  /* VT_SAMPLE_INTV */
+  vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_SAMPLE_INTV: %i",
+                 vt_env_sample_intv());
+#endif /* VT_SAMPLE */
+
 #if defined(VT_IOWRAP)
   /* VT_IOTRACE */
   vt_def_comment(VT_MASTER_THREAD, "__VT_COMMENT__  VT_IOTRACE: %s",
@@ -774,10 +842,6 @@ void vt_open()
   /* initialization specific to this platform */
   vt_pform_init();
 
-  /* make sure the hash tables are zero'd */
-  memset( htab_rdesc, 0, sizeof(htab_rdesc) );
-  memset( htab_sfile, 0, sizeof(htab_sfile) );
-
   /* get maximum stack depth */
   max_stack_depth = vt_env_max_stack_depth();
   if (max_stack_depth == 0) max_stack_depth = 0x7FFFFFFF;
@@ -793,6 +857,8 @@ void vt_open()
 
   /* initialize hardware counters */
   num_metrics = vt_metric_open();
+  if ( num_metrics > 0 )
+    metric_policy_init();
 
 #endif /* VT_METR */
 
@@ -946,6 +1012,10 @@ void vt_open()
 
 #endif /* VT_RUSAGE */
 
+  /* initialize overhead accounting if enabled */
+  if ( vt_env_overhead() )
+    vt_ovhd_init();
+
   /* initialize MPI related stuff */
 
 #if (defined(VT_MPI) || defined(VT_HYB))
@@ -997,6 +1067,14 @@ void vt_open()
 
 #endif /* VT_JAVA || VT_MPI || VT_HYB */
 
+  /* install signal handler for dumping the flight recorder buffers */
+  if (vt_env_flight_recorder() && vt_env_flight_recorder_signal() > 0)
+  {
+    if (signal(vt_env_flight_recorder_signal(), vt_dump_by_signal) == SIG_ERR)
+      vt_warning("Could not install handler for signal %i",
+                 vt_env_flight_recorder_signal());
+  }
+
   init_pid = getpid();
 
 #if defined(VT_METR)
@@ -1140,6 +1218,12 @@ void vt_reset()
   if ( num_metrics > 0 )
     vt_metric_close();
 
+  if ( metric_threshv != NULL )
+  {
+    free(metric_threshv);
+    metric_threshv = NULL;
+  }
+
 #endif /* VT_METR */
 
   /* finalize UniMCI if necessary */
@@ -1191,6 +1275,15 @@ void vt_close_by_signal(int signum)
   exit(signum);
 }
 
+void vt_dump_by_signal(int signum)
+{
+  /* re-install signal handler */
+  signal(signum, vt_dump_by_signal);
+
+  /* write the flight recorder buffers the next time they are full */
+  VTGen_request_dump();
+}
+
 void vt_close()
 {
   int tnum;
@@ -1288,10 +1381,21 @@ void vt_close()
 
 #endif /* VT_LIBWRAP */
 
+#if defined(VT_SAMPLE)
+
+  /* finalize sampling */
+  vt_sample_finalize();
+
+#endif /* VT_SAMPLE */
+
   /* finalize compiler adapter */
   if (vt_comp_finalize)
     vt_comp_finalize();
 
+  /* write accounted overhead if enabled */
+  if (vt_ovhd_on)
+    vt_ovhd_finalize(tnum);
+
   /* write stop-time as comment to definitions */
   {
     uint64_t stop_time_epoch;
@@ -1305,8 +1409,7 @@ void vt_close()
   }
 
   /* close trace files */
-  for (i = 0; i < tnum; i++)
-    VTThrd_close(VTThrdv[i]);
+  VTThrd_closeAll(tnum);
 
 #if (defined(VT_LIBCWRAP) && defined(VT_FORK))
 
@@ -1368,6 +1471,12 @@ void vt_close()
   if ( num_metrics > 0 )
     vt_metric_close();
 
+  if ( metric_threshv != NULL )
+  {
+    free(metric_threshv);
+    metric_threshv = NULL;
+  }
+
 #endif /* VT_METR */
 
   /* finalize resource usage counters */
@@ -1488,27 +1597,78 @@ void vt_update_counter(uint32_t tid, uint64_t* time)
 {
 #if (defined(VT_METR) || defined(VT_RUSAGE) || defined(VT_GETCPU) ||           \
      defined(VT_PLUGIN_CNTR))
+  uint64_t ovhd_time;
+
+  /* the values of all counters are written as a single vector counter
+     record; if there are more than VT_CNTR_BATCH_SIZE of them, the
+     full batches are written in between */
+  uint32_t cidv[VT_CNTR_BATCH_SIZE];
+  uint64_t cvalv[VT_CNTR_BATCH_SIZE];
+  uint32_t num = 0;
+
+# define CNTR_BATCH_ADD(_cid, _cval) \
+  { \
+    if ( num == VT_CNTR_BATCH_SIZE ) { \
+      VTGen_write_COUNTERS(VTTHRD_GEN(VTThrdv[tid]), time, num, cidv, cvalv); \
+      num = 0; \
+    } \
+    cidv[num] = (_cid); cvalv[num] = (_cval); num++; \
+  }
+
   GET_THREAD_ID(tid);
 
+  if ( VTTHRD_TRACE_STATUS(VTThrdv[tid]) != VT_TRACE_ON ) return;
+
+  ovhd_time = VT_OVHD_BEGIN();
+
 #if defined(VT_METR)
-  /* update hardware performance counters (VT_METRICS) */
+  /* update hardware performance counters (VT_METRICS), if at least
+     VT_METRICS_EVENTS events and VT_METRICS_INTV passed since the last
+     reading */
   if ( num_metrics > 0 && VTThrdv[tid]->is_virtual_thread == 0 &&
-       VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_ON )
+       ++VTTHRD_MET_EVENTS(VTThrdv[tid]) >= metric_events &&
+       *(time) >= VTTHRD_MET_NEXT_READ(VTThrdv[tid]) )
   {
+    uint64_t* valv = VTTHRD_VALV(VTThrdv[tid]);
     int i;
 
+    VTTHRD_MET_EVENTS(VTThrdv[tid]) = 0;
+    VTTHRD_MET_NEXT_READ(VTThrdv[tid]) = *(time) + metric_intv;
+
     vt_metric_read(VTTHRD_METV(VTThrdv[tid]),
-                   VTTHRD_OFFV(VTThrdv[tid]),
-                   VTTHRD_VALV(VTThrdv[tid]));
+                   VTTHRD_OFFV(VTThrdv[tid]), valv);
 
-    for ( i = 0; i < num_metrics; i++ )
+    if ( metric_threshv == NULL )
     {
-      if ( VTTHRD_TRACE_STATUS(VTThrdv[tid]) != VT_TRACE_ON) break;
+      for ( i = 0; i < num_metrics; i++ )
+        CNTR_BATCH_ADD(i+1, valv[i]);
+    }
+    else
+    {
+      /* write only values which changed by more than the threshold since
+         they were written last; all values at the first reading */
+      uint64_t* lastv = VTTHRD_MET_LASTV(VTThrdv[tid]);
+      uint8_t first = 0;
 
-      VTGen_write_COUNTER(VTTHRD_GEN(VTThrdv[tid]),
-                          time,
-                          i+1,
-                          VTTHRD_VALV(VTThrdv[tid])[i]);
+      if ( lastv == NULL )
+      {
+        lastv = (uint64_t*)malloc(num_metrics * sizeof(uint64_t));
+        if ( lastv == NULL )
+          vt_error();
+        VTTHRD_MET_LASTV(VTThrdv[tid]) = lastv;
+        first = 1;
+      }
+
+      for ( i = 0; i < num_metrics; i++ )
+      {
+        if ( first ||
+             (valv[i] > lastv[i] ? valv[i] - lastv[i] : lastv[i] - valv[i]) >
+             metric_threshv[i] )
+        {
+          CNTR_BATCH_ADD(i+1, valv[i]);
+          lastv[i] = valv[i];
+        }
+      }
     }
   }
 #endif /* VT_METR */
@@ -1516,7 +1676,6 @@ void vt_update_counter(uint32_t tid, uint64_t* time)
 #if defined(VT_RUSAGE)
   /* update resource usage counters (VT_RUSAGE) */
   if ( num_rusage > 0 &&
-       VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_ON &&
        *(time) >= VTTHRD_RU_NEXT_READ(VTThrdv[tid]) )
   {
     int i;
@@ -1525,15 +1684,8 @@ void vt_update_counter(uint32_t tid, uint64_t* time)
                    VTTHRD_RU_VALV(VTThrdv[tid]), &changed);
     for ( i = 0; i < num_rusage; i++ )
     {
-      if ( VTTHRD_TRACE_STATUS(VTThrdv[tid]) != VT_TRACE_ON) break;
-
       if ( (changed & (1<<i)) != 0 )
-      {
-        VTGen_write_COUNTER(VTTHRD_GEN(VTThrdv[tid]),
-                            time,
-                            vt_rusage_cidv[i],
-                            VTTHRD_RU_VALV(VTThrdv[tid])[i]);
-      }
+        CNTR_BATCH_ADD(vt_rusage_cidv[i], VTTHRD_RU_VALV(VTThrdv[tid])[i]);
     }
 
     VTTHRD_RU_NEXT_READ(VTThrdv[tid]) = *(time) + vt_rusage_intv;
@@ -1542,18 +1694,12 @@ void vt_update_counter(uint32_t tid, uint64_t* time)
 
 #if defined(VT_GETCPU)
   /* update cpu id counter (VT_GETCPU) */
-  if ( vt_env_cpuidtrace() &&
-       VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_ON )
+  if ( vt_env_cpuidtrace() )
   {
     uint8_t changed;
     vt_getcpu_read(&(VTTHRD_CPUID_VAL(VTThrdv[tid])), &changed);
     if ( changed )
-    {
-      VTGen_write_COUNTER(VTTHRD_GEN(VTThrdv[tid]),
-                          time,
-                          vt_getcpu_cid,
-                          VTTHRD_CPUID_VAL(VTThrdv[tid]));
-    }
+      CNTR_BATCH_ADD(vt_getcpu_cid, VTTHRD_CPUID_VAL(VTThrdv[tid]));
   }
 #endif /* VT_GETCPU */
 
@@ -1562,25 +1708,26 @@ void vt_update_counter(uint32_t tid, uint64_t* time)
   /* if we really use plugins and this thread also uses some */
   if (vt_plugin_cntr_used && VTTHRD_PLUGIN_CNTR_DEFINES(VTThrdv[tid]))
   {
-    if (VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_ON)
+    int plugin_metrics = vt_plugin_cntr_get_num_synch_metrics(VTThrdv[tid]);
+    uint32_t counter_id;
+    uint64_t value;
+    int i;
+    for ( i = 0; i < plugin_metrics; i++ )
     {
-      int plugin_metrics = vt_plugin_cntr_get_num_synch_metrics(VTThrdv[tid]);
-      uint32_t counter_id;
-      uint64_t value;
-      int i;
-      for ( i = 0; i < plugin_metrics; i++ )
-      {
-        vt_plugin_cntr_get_synch_value(VTThrdv[tid], i, &counter_id, &value);
-
-        VTGen_write_COUNTER(VTTHRD_GEN(VTThrdv[tid]),
-                            time,
-                            counter_id,
-                            value);
-      }
+      vt_plugin_cntr_get_synch_value(VTThrdv[tid], i, &counter_id, &value);
+      CNTR_BATCH_ADD(counter_id, value);
     }
+    /* write the values of callback plugins, if enough are buffered */
+    vt_plugin_cntr_write_callback_data(VTThrdv[tid], 0);
   }
 #endif /* VT_PLUGIN_CNTR */
 
+  VTGen_write_COUNTERS(VTTHRD_GEN(VTThrdv[tid]), time, num, cidv, cvalv);
+
+# undef CNTR_BATCH_ADD
+
+  VT_OVHD_END(VTThrdv[tid], VT_OVHD_COUNTER, ovhd_time);
+
 #endif /* VT_METR) || VT_RUSAGE || VT_GETCPU || VT_PLUGIN_CNTR */
 }
 
@@ -1797,9 +1944,42 @@ void vt_mpi_sync(uint32_t tid, uint64_t* time, void* comm)
 #endif /* VT_MPI || VT_HYB */
 }
 
+/* get the next identifier from the calling thread's block of identifiers
+   (not from the block of the thread the definition is written to, which
+   may be another one, e.g. VT_MASTER_THREAD); a new block is taken from
+   curid by an atomic add, so that threads defining objects at the same
+   time don't serialize on a mutex */
+static uint32_t get_id(void)
+{
+  uint32_t tid = VT_CURRENT_THREAD;
+  VTThrd* thrd;
+
+  GET_THREAD_ID(tid);
+  thrd = VTThrdv[tid];
+
+  if( thrd->id_next == thrd->id_end )
+  {
+    uint32_t first;
+
+#if defined(VT_HAVE_ATOMICS)
+    first = VT_ATOMIC_FETCH_ADD(&curid, VT_ID_BLOCK_SIZE);
+#else /* VT_HAVE_ATOMICS */
+    VTTHRD_LOCK_IDS();
+    first = curid;
+    curid += VT_ID_BLOCK_SIZE;
+    VTTHRD_UNLOCK_IDS();
+#endif /* VT_HAVE_ATOMICS */
+
+    thrd->id_next = first;
+    thrd->id_end = first + VT_ID_BLOCK_SIZE;
+  }
+
+  return thrd->id_next++;
+}
+
 uint32_t vt_get_curid()
 {
-  return curid++;
+  return get_id();
 }
 
 /*
@@ -1828,7 +2008,7 @@ uint32_t vt_def_scl_file(uint32_t tid, const char* fname)
 {
   uint32_t fid;
 
-  HashNode_sfile* hn;
+  uint32_t* hn;
 
   GET_THREAD_ID(tid);
 
@@ -1836,7 +2016,7 @@ uint32_t vt_def_scl_file(uint32_t tid, const char* fname)
 
   if( hn == NULL )
   {
-    fid = curid++;
+    fid = get_id();
 
     VTGen_write_DEF_SCL_FILE(VTTHRD_GEN(VTThrdv[tid]), fid, fname);
 
@@ -1844,7 +2024,7 @@ uint32_t vt_def_scl_file(uint32_t tid, const char* fname)
   }
   else
   {
-    fid = hn->fid;
+    fid = *hn;
   }
 
   return fid;
@@ -1859,7 +2039,7 @@ uint32_t vt_def_scl(uint32_t tid, uint32_t fid, uint32_t begln, uint32_t endln)
   if( fid == VT_NO_ID || begln == VT_NO_LNO )
     return 0;
 
-  sid = curid++;
+  sid = get_id();
 
   VTGen_write_DEF_SCL(VTTHRD_GEN(VTThrdv[tid]), sid, fid, begln);
 
@@ -1873,7 +2053,7 @@ uint32_t vt_def_file_group(uint32_t tid, const char* gname)
   GET_THREAD_ID(tid);
 
 
-  gid = curid++;
+  gid = get_id();
 
   VTGen_write_DEF_FILE_GROUP(VTTHRD_GEN(VTThrdv[tid]), gid, gname);
 
@@ -1886,7 +2066,7 @@ uint32_t vt_def_file(uint32_t tid, const char* fname, uint32_t gid)
 
   GET_THREAD_ID(tid);
 
-  fid = curid++;
+  fid = get_id();
 
   VTGen_write_DEF_FILE(VTTHRD_GEN(VTThrdv[tid]),
                        fid,
@@ -1900,7 +2080,7 @@ uint32_t vt_def_region_group(uint32_t tid, const char* gname)
 {
   uint32_t rdid;
 
-  HashNode_rdesc* hn;
+  uint32_t* hn;
 
   GET_THREAD_ID(tid);
 
@@ -1908,7 +2088,7 @@ uint32_t vt_def_region_group(uint32_t tid, const char* gname)
 
   if(hn == NULL)
   {
-    rdid = curid++;
+    rdid = get_id();
 
     VTGen_write_DEF_FUNCTION_GROUP(VTTHRD_GEN(VTThrdv[tid]),
                                     rdid, gname);
@@ -1917,7 +2097,7 @@ uint32_t vt_def_region_group(uint32_t tid, const char* gname)
   }
   else
   {
-    rdid = hn->rdid;
+    rdid = *hn;
   }
 
   return rdid;
@@ -1937,7 +2117,7 @@ uint32_t vt_def_region(uint32_t tid, const char* rname, uint32_t fid,
   GET_THREAD_ID(tid);
 
   sid = vt_def_scl(tid, fid, begln, endln);
-  rid = curid++;
+  rid = get_id();
 
 #if !defined(VT_DISABLE_RFG)
   /* get region's filter/group information */
@@ -2050,7 +2230,7 @@ uint32_t vt_def_counter_group(uint32_t tid, const char* gname)
 
   GET_THREAD_ID(tid);
 
-  gid = curid++;
+  gid = get_id();
 
   VTGen_write_DEF_COUNTER_GROUP(VTTHRD_GEN(VTThrdv[tid]), gid, gname);
 
@@ -2068,7 +2248,7 @@ uint32_t vt_def_counter(uint32_t tid, const char* cname, uint32_t cprop,
   cid = num_metrics;
 #endif /* VT_METR */
 
-  cid += curid++;
+  cid += get_id();
 
   VTGen_write_DEF_COUNTER(VTTHRD_GEN(VTThrdv[tid]),
                           cid,
@@ -2086,7 +2266,7 @@ uint32_t vt_def_marker(uint32_t tid, const char* mname, uint32_t mtype)
 
   GET_THREAD_ID(tid);
 
-  mid = curid++;
+  mid = get_id();
 
   VTGen_write_DEF_MARKER(VTTHRD_GEN(VTThrdv[tid]),
                          mid,
@@ -2127,7 +2307,7 @@ uint32_t vt_def_mpi_comm(uint32_t tid, uint8_t ctype, uint32_t grpc,
 
   GET_THREAD_ID(tid);
 
-  cid = curid++;
+  cid = get_id();
 
   cgrpv = (uint32_t*)calloc(grpc * 8, sizeof(uint32_t));
   if( cgrpv == NULL )
@@ -2172,41 +2352,55 @@ uint8_t vt_enter(uint32_t tid, uint64_t* time, uint32_t rid)
 {
 #if !defined(VT_DISABLE_RFG)
   RFG_RegionInfo* rinf;
+  uint64_t rfg_time;
 #endif
   uint8_t do_trace;
+  uint64_t ovhd_time;
 
   GET_THREAD_ID(tid);
 
   if (VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_OFF_PERMANENT) return 0;
 
+  ovhd_time = VT_OVHD_BEGIN();
+
+#if defined(VT_SAMPLE)
+  /* write pending samples before the region is entered */
+  if (VTTHRD_SAMPLE(VTThrdv[tid]))
+    vt_sample_sync(tid, time, 0);
+#endif /* VT_SAMPLE */
+
   VTTHRD_STACK_PUSH(VTThrdv[tid]);
 
   do_trace = ((VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_ON) &&
               (VTTHRD_STACK_LEVEL(VTThrdv[tid]) <= max_stack_depth));
 
 #if !defined(VT_DISABLE_RFG)
+  rfg_time = VT_OVHD_BEGIN();
+
   if( !RFG_Regions_stackPush(VTTHRD_RFGREGIONS(VTThrdv[tid]),
                              rid, do_trace, &rinf) )
   {
 #   if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA) || defined(VT_CUDARTWRAP))
     RFG_RegionInfo* rinf_master;
+
+    /* region entered the first time by this thread; get master's region
+       info from its rid-indexed table, which doesn't require locking */
+    rinf_master = RFG_Regions_getIndexed(VTTHRD_RFGREGIONS(VTThrdv[0]), rid);
+    if (rinf_master == NULL)
+    {
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-    VTTHRD_LOCK_IDS();
+      VTTHRD_LOCK_IDS();
 #endif /* VT_MT || VT_HYB || V_JAVA */
-    rinf_master = RFG_Regions_get(VTTHRD_RFGREGIONS(VTThrdv[0]), rid);
+      rinf_master = RFG_Regions_get(VTTHRD_RFGREGIONS(VTThrdv[0]), rid);
 #if (defined(VT_MT) || defined(VT_HYB) || defined(VT_JAVA))
-    VTTHRD_UNLOCK_IDS();
+      VTTHRD_UNLOCK_IDS();
 #endif /* VT_MT || VT_HYB || V_JAVA */
+    }
     vt_assert(rinf_master != NULL);
 
-    rinf = RFG_Regions_add(VTTHRD_RFGREGIONS(VTThrdv[tid]),
-                           rinf_master->regionName, rid);
-
-    /* copy master's call limit */
-    rinf->callLimit = rinf_master->callLimit;
-
-    /* initialize call limit count down */
-    rinf->callLimitCD = rinf->callLimit;
+    /* copy master's region info including its call limit; the filter and
+       group definitions were already evaluated at the region definition */
+    rinf = RFG_Regions_addCopy(VTTHRD_RFGREGIONS(VTThrdv[tid]), rinf_master);
 
     if (!RFG_Regions_stackPush(VTTHRD_RFGREGIONS(VTThrdv[tid]),
                                rid, do_trace, &rinf))
@@ -2216,6 +2410,8 @@ uint8_t vt_enter(uint32_t tid, uint64_t* time, uint32_t rid)
 #   endif /* VT_MT || VT_HYB || VT_JAVA || VT_CUDARTWRAP */
   }
 
+  VT_OVHD_END(VTThrdv[tid], VT_OVHD_RFG, rfg_time);
+
   if (do_trace)
   {
     /* write marker, if the next enter will reach the call limit */
@@ -2244,6 +2440,8 @@ uint8_t vt_enter(uint32_t tid, uint64_t* time, uint32_t rid)
     vt_update_counter(tid, time);
   }
 
+  VT_OVHD_END(VTThrdv[tid], VT_OVHD_ENTER, ovhd_time);
+
   return do_trace;
 }
 
@@ -2252,26 +2450,41 @@ void vt_exit(uint32_t tid, uint64_t* time)
 #if !defined(VT_DISABLE_RFG)
   RFG_RegionInfo* rinf;
   int climitbyenter;
+  uint64_t rfg_time;
 #endif
   uint8_t do_trace;
+  uint64_t ovhd_time;
 
   GET_THREAD_ID(tid);
 
   if (VTTHRD_TRACE_STATUS(VTThrdv[tid]) ==
       VT_TRACE_OFF_PERMANENT) return;
 
+  ovhd_time = VT_OVHD_BEGIN();
+
+#if defined(VT_SAMPLE)
+  /* write pending samples and leave the sampled regions, which are
+     nested in the region to be left */
+  if (VTTHRD_SAMPLE(VTThrdv[tid]))
+    vt_sample_sync(tid, time, 1);
+#endif /* VT_SAMPLE */
+
   VTTHRD_STACK_POP(VTThrdv[tid]);
 
   do_trace = ((VTTHRD_TRACE_STATUS(VTThrdv[tid]) == VT_TRACE_ON) &&
               (VTTHRD_STACK_LEVEL(VTThrdv[tid])+1 <= max_stack_depth));
 
 #if !defined(VT_DISABLE_RFG)
+  rfg_time = VT_OVHD_BEGIN();
+
   if (!RFG_Regions_stackPop(VTTHRD_RFGREGIONS(VTThrdv[tid]),
                             &rinf, &climitbyenter))
   {
     vt_assert(0);
   }
 
+  VT_OVHD_END(VTThrdv[tid], VT_OVHD_RFG, rfg_time);
+
   if (climitbyenter == 0)
     do_trace = 0;
 #endif /* VT_DISABLE_RFG */
@@ -2282,6 +2495,8 @@ void vt_exit(uint32_t tid, uint64_t* time)
 
     VTGen_write_LEAVE(VTTHRD_GEN(VTThrdv[tid]), time, 0, 0);
   }
+
+  VT_OVHD_END(VTThrdv[tid], VT_OVHD_EXIT, ovhd_time);
 }
 
 /* -- File I/O -- */
@@ -53,6 +53,13 @@ EXTERN void vt_reset(void);
  */
 EXTERN void vt_close_by_signal(int signum);
 
+/**
+ * Description
+ *
+ * @param signum  signal number
+ */
+EXTERN void vt_dump_by_signal(int signum);
+
 /**
  * Description
  */
@@ -45,13 +45,7 @@ unsigned int VT_User_count_group_def__(const char* gname)
 
   VT_MEMHOOKS_OFF();
 
-#if (defined(VT_MT) || defined(VT_HYB))
-  VTTHRD_LOCK_IDS();
-#endif
   gid = vt_def_counter_group(VT_CURRENT_THREAD, gname);
-#if (defined(VT_MT) || defined(VT_HYB))
-  VTTHRD_UNLOCK_IDS();
-#endif
 
   VT_MEMHOOKS_ON();
 
@@ -108,13 +102,7 @@ unsigned int VT_User_count_def__(const char* cname, const char* cunit, int ctype
     }
   }
 
-#if (defined(VT_MT) || defined(VT_HYB))
-  VTTHRD_LOCK_IDS();
-#endif
   cid = vt_def_counter(VT_CURRENT_THREAD, cname, cprop, gid, cunit);
-#if (defined(VT_MT) || defined(VT_HYB))
-  VTTHRD_UNLOCK_IDS();
-#endif
 
     VT_MEMHOOKS_ON();
 
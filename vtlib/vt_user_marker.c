@@ -67,13 +67,7 @@ unsigned int VT_User_marker_def__(const char* mname, int mtype)
     }
   }
 
-#if (defined(VT_MT) || defined(VT_HYB))
-  VTTHRD_LOCK_IDS();
-#endif
   mid = vt_def_marker(VT_CURRENT_THREAD, mname, _mtype);
-#if (defined(VT_MT) || defined(VT_HYB))
-  VTTHRD_UNLOCK_IDS();
-#endif
 
   VT_MEMHOOKS_ON();
 